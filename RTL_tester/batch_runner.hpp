@@ -0,0 +1,421 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "sim_core_vcd_conv.hpp"
+#include "rtl_core_vcd_conv.hpp"
+#include "signal_comparator.hpp"
+#include "spike_commit_source.hpp"
+#include "rtl_commit_source.hpp"
+#include "compressed_file.hpp"
+#include "work_stealing_pool.hpp"
+
+// One test of a batch manifest: a sim/RTL dump pair, or an RTL dump checked against a Spike commit log
+struct batch_test {
+    std::string name;
+    std::string simVcd, rtlVcd, spikeLog;
+    std::string simCsv, rtlCsv;             // optional side outputs of the conversion
+    std::set<std::string> simSignals, rtlSignals;
+    std::map<std::string, std::string> compareMap;
+    std::string alignKey1, alignKey2;
+    rtl_commit_signals commitSignals;       // Spike tests
+    std::string clock = "dut.clk";          // RTL clock of Spike tests: the one signal rows are sampled on
+    int hart = -1;
+    long maxMismatches = 0;
+    int window = 0;
+};
+
+// Reads a manifest of tests. Each test is a [name] section of "key = value" lines; lines before the
+// first section are defaults for every test, so shared signal sets are written once. '#' starts a
+// comment, and relative paths are taken from the manifest's directory.
+//
+//   rtl_signals = dut.clk u_writeback.*
+//   sim_signals = Module.Clock Module.u_writeback.*
+//   compare = Module.u_writeback.writeback2memory_pc_in cpu_top_tb.dut.u_cpu.u_writeback.pc_in
+//
+//   [add_loop]
+//   sim = add_loop/dump.vcd
+//   rtl = add_loop/cpu_top_tb.vcd.gz
+//
+//   [add_loop_spike]
+//   spike = add_loop/commit_trace.log
+//   rtl = add_loop/cpu_top_tb.vcd.gz
+//   wb_pc = cpu_top_tb.dut.u_cpu.u_writeback.pc_in
+//
+// Keys: sim, rtl, spike, hart, sim_csv, rtl_csv, sim_signals, rtl_signals (space separated, may repeat),
+// compare (sim name, RTL name; may repeat), align (the two commit key signals), max_mismatches, window,
+// and for Spike tests clock (default dut.clk), wb_valid, wb_pc, wb_rd_addr, wb_rd_data, mem_valid,
+// mem_pc, mem_addr, mem_data, mem_write (see rtl_commit_signals). A test that sets sim_signals,
+// rtl_signals or compare replaces the defaults of that key instead of adding to them. Test names
+// become report file names, so they must be unique and must not contain '/' or "..".
+class batch_manifest {
+private:
+    using Entries = std::vector<std::pair<std::string, std::string>>;
+
+    static std::string trim(const std::string& s) {
+        size_t b = s.find_first_not_of(" \t\r");
+        if (b == std::string::npos) return "";
+        return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+    }
+
+    static std::vector<std::string> words(const std::string& s) {
+        std::vector<std::string> all;
+        std::istringstream in(s);
+        std::string w;
+        while (in >> w) all.push_back(w);
+        return all;
+    }
+
+    static bool repeats(const std::string& key) { return key == "sim_signals" || key == "rtl_signals" || key == "compare"; }
+
+    static bool apply(batch_test& t, const std::string& key, const std::string& value, const std::string& dir) {
+        auto path = [&](std::string& field) {
+            field = value.empty() || std::filesystem::path(value).is_absolute() ? value : dir + value;
+        };
+        std::vector<std::string> w = words(value);
+        if (key == "sim") path(t.simVcd);
+        else if (key == "rtl") path(t.rtlVcd);
+        else if (key == "spike") path(t.spikeLog);
+        else if (key == "sim_csv") path(t.simCsv);
+        else if (key == "rtl_csv") path(t.rtlCsv);
+        else if (key == "hart") t.hart = std::stoi(value);
+        else if (key == "clock" && w.size() == 1) t.clock = value;
+        else if (key == "max_mismatches") t.maxMismatches = std::stol(value);
+        else if (key == "window") t.window = std::stoi(value);
+        else if (key == "sim_signals") t.simSignals.insert(w.begin(), w.end());
+        else if (key == "rtl_signals") t.rtlSignals.insert(w.begin(), w.end());
+        else if (key == "compare" && w.size() == 2) t.compareMap[w[0]] = w[1];
+        else if (key == "align" && w.size() == 2) {
+            t.alignKey1 = w[0];
+            t.alignKey2 = w[1];
+        }
+        else if (key == "wb_valid") t.commitSignals.wbValid = value;
+        else if (key == "wb_pc") t.commitSignals.wbPc = value;
+        else if (key == "wb_rd_addr") t.commitSignals.wbRdAddr = value;
+        else if (key == "wb_rd_data") t.commitSignals.wbRdData = value;
+        else if (key == "mem_valid") t.commitSignals.memValid = value;
+        else if (key == "mem_pc") t.commitSignals.memPc = value;
+        else if (key == "mem_addr") t.commitSignals.memAddr = value;
+        else if (key == "mem_data") t.commitSignals.memData = value;
+        else if (key == "mem_write") t.commitSignals.memWrite = value;
+        else return false;
+        return true;
+    }
+
+public:
+    static bool load(const std::string& path, std::vector<batch_test>& tests) {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Error: Could not open manifest " << path << std::endl;
+            return false;
+        }
+        std::string dir = std::filesystem::path(path).parent_path().string();
+        if (!dir.empty()) dir += '/';
+
+        Entries defaults;
+        std::vector<std::pair<std::string, Entries>> sections;
+        std::vector<int> sectionLines;
+        std::string line;
+        for (int lineNo = 1; std::getline(in, line); ++lineNo) {
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty()) continue;
+            if (line.front() == '[' && line.back() == ']') {
+                sections.push_back({trim(line.substr(1, line.size() - 2)), {}});
+                sectionLines.push_back(lineNo);
+                continue;
+            }
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) {
+                std::cerr << "Error: " << path << ":" << lineNo << ": expected key = value" << std::endl;
+                return false;
+            }
+            (sections.empty() ? defaults : sections.back().second).push_back({trim(line.substr(0, eq)), trim(line.substr(eq + 1))});
+        }
+
+        std::set<std::string> names;
+        for (size_t s = 0; s < sections.size(); ++s) {
+            const auto& [name, own] = sections[s];
+            const char* badName = name.empty() ? "an empty name" : name.find('/') != std::string::npos ||
+                                  name.find('\\') != std::string::npos || name.find("..") != std::string::npos
+                                  ? "a name that is not a plain file name" : !names.insert(name).second ? "a duplicate name" : nullptr;
+            if (badName != nullptr) {
+                std::cerr << "Error: " << path << ":" << sectionLines[s] << ": test [" << name << "] has " << badName << std::endl;
+                return false;
+            }
+            Entries all;
+            for (const auto& e : defaults) {
+                bool overridden = repeats(e.first) &&
+                                  std::any_of(own.begin(), own.end(), [&](const auto& o) { return o.first == e.first; });
+                if (!overridden) all.push_back(e);
+            }
+            all.insert(all.end(), own.begin(), own.end());
+
+            batch_test t;
+            t.name = name;
+            for (const auto& [key, value] : all) {
+                bool known;
+                try {
+                    known = apply(t, key, value, dir);
+                } catch (const std::exception&) {
+                    known = false;
+                }
+                if (!known) {
+                    std::cerr << "Error: " << path << ": test " << name << ": bad entry " << key << " = " << value << std::endl;
+                    return false;
+                }
+            }
+            const char* missing = t.rtlVcd.empty() ? "rtl" : t.simVcd.empty() && t.spikeLog.empty() ? "sim or spike"
+                                : !t.spikeLog.empty() && t.commitSignals.wbPc.empty() ? "wb_pc"
+                                : t.spikeLog.empty() && t.compareMap.empty() ? "compare" : nullptr;
+            if (missing != nullptr) {
+                std::cerr << "Error: " << path << ":" << sectionLines[s] << ": test " << name << " has no " << missing << std::endl;
+                return false;
+            }
+            tests.push_back(std::move(t));
+        }
+        return true;
+    }
+};
+
+// Runs the tests of a manifest on a work-stealing pool, one test per job and one thread per test, and
+// prints one combined summary. Jobs only start while the estimated memory of the running tests (their
+// mapped dumps, or decode buffers for compressed ones) fits the limit; a test larger than the whole
+// limit runs on its own. Every test's detailed report is written to reportDir/<name>.txt.
+class batch_runner {
+public:
+    struct Result {
+        std::string name;
+        int cycles = 0;
+        long mismatches = 0;
+        long unmatched = 0;
+        std::map<std::string, signal_comparator::Stats> stats;
+        double seconds = 0;
+        std::string error;                  // why nothing or not everything was compared, e.g. a truncated dump
+
+        bool passed() const { return error.empty() && !stats.empty() && cycles > 0 && mismatches == 0 && unmatched == 0; }
+        const char* status() const { return !error.empty() || stats.empty() || cycles == 0 ? "ERROR" : passed() ? "PASSED" : "FAILED"; }
+    };
+
+private:
+    std::vector<batch_test> tests;
+    int threads;
+    uint64_t memoryLimit;                   // bytes; 0 = no limit
+    std::string reportDir;
+    std::vector<Result> results;
+
+    std::mutex memoryLock;
+    std::condition_variable memoryFreed;
+    uint64_t memoryUsed = 0;
+    int running = 0;
+
+    std::mutex printLock;
+    size_t finished = 0;
+
+    static uint64_t inputBytes(const std::string& path) {
+        if (path.empty()) return 0;
+        if (compressed_file::detect(path) != compressed_file::Plain) return uint64_t(64) << 20;
+        std::error_code ec;
+        uint64_t n = std::filesystem::file_size(path, ec);
+        return ec ? 0 : n;
+    }
+
+    static uint64_t estimate(const batch_test& t) {
+        return inputBytes(t.simVcd) + inputBytes(t.rtlVcd) + inputBytes(t.spikeLog) + (uint64_t(16) << 20);
+    }
+
+    void acquire(uint64_t bytes) {
+        std::unique_lock<std::mutex> lk(memoryLock);
+        memoryFreed.wait(lk, [&] { return memoryLimit == 0 || running == 0 || memoryUsed + bytes <= memoryLimit; });
+        memoryUsed += bytes;
+        running++;
+    }
+
+    void release(uint64_t bytes) {
+        {
+            std::lock_guard<std::mutex> g(memoryLock);
+            memoryUsed -= bytes;
+            running--;
+        }
+        memoryFreed.notify_all();
+    }
+
+    template <typename Converter>
+    static std::string readError(const Converter& parser, const std::string& path) {
+        return parser.hasFailed() ? path + " ends early (decode error)" : "";
+    }
+
+    // Returns why the comparison could not run to the end, empty if it did
+    static std::string compare(const batch_test& t, signal_comparator& comparator) {
+        if (t.spikeLog.empty()) {
+            sim_core_vcd_conv simParser(t.simVcd, t.simCsv, t.simSignals, 1);
+            rtl_core_vcd_conv rtlParser(t.rtlVcd, t.rtlCsv, t.rtlSignals, 1);
+            if (!simParser.open(!t.simCsv.empty())) return "could not open " + t.simVcd;
+            if (!rtlParser.open(!t.rtlCsv.empty())) return "could not open " + t.rtlVcd;
+            if (!simParser.hasClock()) return "no clock in the sim signals";
+            if (!rtlParser.hasClock()) return "no clock in the rtl signals";
+            comparator.compareStreams(simParser, rtlParser, t.compareMap);
+            std::string error = readError(simParser, t.simVcd);
+            return error.empty() ? readError(rtlParser, t.rtlVcd) : error;
+        }
+
+        std::set<std::string> signals = t.commitSignals.names();
+        signals.insert(t.rtlSignals.begin(), t.rtlSignals.end());
+        spike_commit_source spike(t.spikeLog, t.hart);
+        rtl_core_vcd_conv rtlParser(t.rtlVcd, t.rtlCsv, signals, 1);
+        rtlParser.setClock(t.clock);
+        if (!spike.open()) return "could not open " + t.spikeLog;
+        if (!rtlParser.open(!t.rtlCsv.empty())) return "could not open " + t.rtlVcd + " or find clock " + t.clock;
+        if (rtlParser.clockName().empty()) return "clock " + t.clock + " not found in " + t.rtlVcd;
+        std::map<std::string, std::string> checkMap = {
+            {"spike.pc", t.commitSignals.wbPc},
+            {"spike.rd_addr", t.commitSignals.wbRdAddr},
+            {"spike.rd_data", t.commitSignals.wbRdData}
+        };
+        if (!t.commitSignals.memValid.empty()) {
+            checkMap["spike.mem_addr"] = t.commitSignals.memAddr;
+            checkMap["spike.mem_data"] = t.commitSignals.memData;
+        }
+        rtl_commit_source<rtl_core_vcd_conv> rtlCommits(rtlParser, t.commitSignals);
+        if (rtlCommits.isValid()) comparator.compareStreams(spike, rtlCommits, checkMap);
+        return readError(rtlParser, t.rtlVcd);
+    }
+
+    void runTest(size_t i) {
+        const batch_test& t = tests[i];
+        uint64_t bytes = estimate(t);
+        acquire(bytes);
+        auto start = std::chrono::steady_clock::now();
+
+        std::ostringstream report;
+        signal_comparator comparator;
+        comparator.setOutput(report);
+        comparator.setEarlyAbort(t.maxMismatches, t.window);
+        if (!t.alignKey1.empty()) comparator.setAlignment(t.alignKey1, t.alignKey2);
+        std::string error = compare(t, comparator);
+
+        Result& r = results[i];
+        r.name = t.name;
+        r.cycles = comparator.cyclesCompared();
+        r.mismatches = comparator.mismatchCount();
+        r.unmatched = comparator.unmatchedCount();
+        r.stats = comparator.pairStats();
+        // A comparison that checked nothing proves nothing, so it does not pass
+        r.error = !error.empty() ? error : r.stats.empty() ? "no signal pair compared" : r.cycles == 0 ? "no cycles compared" : "";
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        release(bytes);
+
+        if (!reportDir.empty()) std::ofstream(reportDir + "/" + t.name + ".txt") << report.str();
+        std::lock_guard<std::mutex> g(printLock);
+        finished++;
+        std::cout << "[" << finished << "/" << tests.size() << "] " << t.name << " " << r.status() << " ("
+                  << r.cycles << " cycles, " << r.seconds << " s)";
+        if (!r.error.empty()) std::cout << ": " << r.error;
+        std::cout << std::endl;
+    }
+
+    void printSummary(double seconds) const {
+        int spaces = 100;
+        char line[512];
+        std::cout << "\n" << std::string(spaces, '=') << std::endl;
+        std::cout << "                BATCH REGRESSION SUMMARY" << std::endl;
+        std::cout << std::string(spaces, '=') << std::endl;
+        std::snprintf(line, sizeof(line), "%-52s | %-10s | %-10s | %-9s | %-6s\n", "Test", "Cycles", "Mismatch", "Pass Rate", "Status");
+        std::cout << line << std::string(spaces, '-') << std::endl;
+
+        int passed = 0;
+        long cycles = 0, mismatches = 0;
+        for (const Result& r : results) {
+            long checks = 0, failed = 0;
+            for (const auto& [pair, stat] : r.stats) {
+                checks += stat.checks;
+                failed += stat.mismatches;
+            }
+            double passRate = checks > 0 ? 100.0 * (checks - failed) / checks : 0.0;
+            std::snprintf(line, sizeof(line), "%-52s | %-10d | %-10ld | %8.2f%% | %-6s\n", r.name.c_str(), r.cycles,
+                          r.mismatches, passRate, r.status());
+            std::cout << line;
+            passed += r.passed();
+            cycles += r.cycles;
+            mismatches += r.mismatches;
+        }
+
+        std::cout << std::string(spaces, '=') << std::endl;
+        std::cout << " SUMMARY STATISTICS" << std::endl;
+        std::cout << " Tests Passed           : " << passed << " / " << results.size() << std::endl;
+        std::cout << " Total Cycles Processed : " << cycles << std::endl;
+        std::cout << " Total Mismatches       : " << mismatches << std::endl;
+        std::cout << " Wall Time              : " << seconds << " s on " << threads << " threads" << std::endl;
+        std::cout << " Final Status           : " << (passed == (int)results.size() ? "PASSED" : "FAILED") << std::endl;
+        std::cout << std::string(spaces, '=') << std::endl;
+
+        bool header = false;
+        for (const Result& r : results) {
+            for (const auto& [pair, stat] : r.stats) {
+                if (stat.mismatches == 0) continue;
+                if (!header) std::cout << " Mismatching signal pairs:" << std::endl;
+                header = true;
+                std::cout << "   " << r.name << ": " << pair << " (" << stat.mismatches << " of " << stat.checks << ")" << std::endl;
+            }
+        }
+        header = false;
+        for (const Result& r : results) {
+            if (r.error.empty()) continue;
+            if (!header) std::cout << " Errors:" << std::endl;
+            header = true;
+            std::cout << "   " << r.name << ": " << r.error << std::endl;
+        }
+    }
+
+public:
+    // threadCount 0 = one per core; memoryLimitBytes 0 = 80% of the memory available now (Linux), if known
+    batch_runner(std::vector<batch_test> batch, int threadCount = 0, uint64_t memoryLimitBytes = 0, std::string reports = "")
+        : tests(std::move(batch)), threads(threadCount > 0 ? threadCount : (int)std::thread::hardware_concurrency()),
+          memoryLimit(memoryLimitBytes > 0 ? memoryLimitBytes : availableMemory() / 10 * 8), reportDir(std::move(reports)) {
+        if (threads < 1) threads = 1;
+    }
+
+    // MemAvailable from /proc/meminfo, 0 if unknown
+    static uint64_t availableMemory() {
+        std::ifstream meminfo("/proc/meminfo");
+        std::string key;
+        uint64_t kb;
+        while (meminfo >> key >> kb) {
+            if (key == "MemAvailable:") return kb * 1024;
+            meminfo.ignore(256, '\n');
+        }
+        return 0;
+    }
+
+    // True when every test passed
+    bool run() {
+        results.assign(tests.size(), Result());
+        if (!reportDir.empty()) std::filesystem::create_directories(reportDir);
+        auto start = std::chrono::steady_clock::now();
+
+        // Smallest first: a worker runs the newest job of its own deque, so each starts with its largest
+        // test, and idle workers steal the small ones from the other end
+        std::vector<std::pair<uint64_t, size_t>> order;
+        for (size_t i = 0; i < tests.size(); ++i) order.push_back({estimate(tests[i]), i});
+        std::sort(order.begin(), order.end());
+        {
+            work_stealing_pool pool(std::min<int>(threads, std::max<int>(1, (int)tests.size())));
+            std::vector<work_stealing_pool::job> jobs;
+            for (const auto& [bytes, i] : order) jobs.push_back([this, i = i] { runTest(i); });
+            pool.submit(std::move(jobs));
+            pool.wait();
+        }
+
+        printSummary(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        return std::all_of(results.begin(), results.end(), [](const Result& r) { return r.passed(); });
+    }
+};
@@ -0,0 +1,232 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#ifndef VCD_NO_ZLIB
+#include <zlib.h>
+#endif
+#ifdef VCD_WITH_ZSTD
+#include <zstd.h>
+#endif
+#include "mapped_file.hpp"
+#include "spsc_queue.hpp"
+#include "vcd_lexer.hpp"
+
+// Reads a gzip (.vcd.gz) or zstd (.vcd.zst) compressed dump as a vcd_stream, without a decompressed
+// copy on disk or in memory. Decoder threads fill chunks that are handed over through spsc_queues
+// and appended to the lexer's window one at a time.
+//
+// gzip is decoded on one thread through zlib (link with -lz; define VCD_NO_ZLIB to build without).
+// zstd needs -DVCD_WITH_ZSTD -lzstd. A zstd file made of several frames (pzstd, or the seekable
+// format) is split at the frame boundaries and the frames are decoded on decodeThreads threads,
+// frame f on thread f % decodeThreads; the reader takes the frames back in order.
+class compressed_file : public vcd_stream {
+public:
+    enum Format { Plain, Gzip, Zstd };
+
+private:
+    std::string path;
+    Format format = Plain;
+    size_t chunkBytes;
+    int decodeThreads;
+    std::vector<std::unique_ptr<spsc_queue<std::string>>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> failed{false};
+    mapped_file compressed;                 // zstd: the whole file, split into frames
+    std::vector<std::string_view> frames;
+    std::string window;
+    std::string chunk;
+    size_t current = 0;                     // queue the next chunk comes from
+    size_t finished = 0;                    // queues closed and drained
+    uint64_t decoded = 0;                   // bytes handed to the lexer
+
+    void fail(const std::string& message) {
+        std::cerr << "Error: " << path << ": " << message << std::endl;
+        failed.store(true);
+    }
+
+#ifndef VCD_NO_ZLIB
+    void decodeGzip() {
+        spsc_queue<std::string>& queue = *queues[0];
+        gzFile gz = gzopen(path.c_str(), "rb");
+        if (gz == nullptr) fail("could not open");
+        else {
+            gzbuffer(gz, 1 << 20);
+            std::string buf;
+            for (;;) {
+                buf.resize(chunkBytes);
+                int n = gzread(gz, &buf[0], (unsigned)buf.size());
+                if (n <= 0) {
+                    // A missing trailer only shows up as an error at the end
+                    int err;
+                    std::string message = gzerror(gz, &err);
+                    if (message.compare(0, path.size() + 2, path + ": ") == 0) message.erase(0, path.size() + 2);
+                    if (err != Z_OK) fail(message);
+                    break;
+                }
+                buf.resize(n);
+                if (!queue.push(buf, cancelled)) break;
+            }
+            gzclose(gz);
+        }
+        queue.close();
+    }
+#endif
+
+#ifdef VCD_WITH_ZSTD
+    bool splitFrames() {
+        std::string_view rest = compressed.view();
+        while (!rest.empty()) {
+            size_t n = ZSTD_findFrameCompressedSize(rest.data(), rest.size());
+            if (ZSTD_isError(n)) {
+                fail(ZSTD_getErrorName(n));
+                return false;
+            }
+            frames.push_back(rest.substr(0, n));
+            rest.remove_prefix(n);
+        }
+        return true;
+    }
+
+    // Each frame is followed by an empty chunk, so the reader knows when to move to the next queue
+    void decodeZstd(size_t worker) {
+        spsc_queue<std::string>& queue = *queues[worker];
+        ZSTD_DCtx* dctx = ZSTD_createDCtx();
+        std::string buf;
+        bool ok = true;
+        for (size_t f = worker; ok && f < frames.size(); f += queues.size()) {
+            ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+            ZSTD_inBuffer in = {frames[f].data(), frames[f].size(), 0};
+            for (size_t ret = 1; ok && ret != 0;) {
+                buf.resize(chunkBytes);
+                ZSTD_outBuffer out = {&buf[0], buf.size(), 0};
+                ret = ZSTD_decompressStream(dctx, &out, &in);
+                if (ZSTD_isError(ret)) {
+                    fail(ZSTD_getErrorName(ret));
+                    ok = false;
+                } else if (ret != 0 && in.pos == in.size && out.pos < out.size) {
+                    fail("truncated zstd frame");
+                    ok = false;
+                }
+                buf.resize(out.pos);
+                if (!buf.empty()) ok = ok && queue.push(buf, cancelled);
+            }
+            buf.clear();
+            ok = ok && queue.push(buf, cancelled);
+        }
+        ZSTD_freeDCtx(dctx);
+        queue.close();
+    }
+#endif
+
+    void stop() {
+        cancelled.store(true);
+        for (auto& w : workers) w.join();
+        workers.clear();
+        queues.clear();
+    }
+
+public:
+    explicit compressed_file(int threads = std::thread::hardware_concurrency(), size_t chunkSize = size_t(4) << 20)
+        : chunkBytes(chunkSize), decodeThreads(threads < 1 ? 1 : threads) {}
+    ~compressed_file() { stop(); }
+
+    compressed_file(const compressed_file&) = delete;
+    compressed_file& operator=(const compressed_file&) = delete;
+
+    // Format from the magic bytes, so the file name does not matter
+    static Format detect(const std::string& file) {
+        unsigned char magic[4] = {0, 0, 0, 0};
+        FILE* f = std::fopen(file.c_str(), "rb");
+        if (f == nullptr) return Plain;
+        size_t n = std::fread(magic, 1, sizeof(magic), f);
+        std::fclose(f);
+        if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) return Gzip;
+        if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) return Zstd;
+        return Plain;
+    }
+
+    bool open(const std::string& file) {
+        stop();
+        path = file;
+        format = detect(file);
+        cancelled.store(false);
+        failed.store(false);
+        window.clear();
+        current = finished = 0;
+        decoded = 0;
+
+        size_t decoders = 1;
+        if (format == Gzip) {
+#ifdef VCD_NO_ZLIB
+            fail("built without zlib (VCD_NO_ZLIB)");
+            return false;
+#endif
+        } else if (format == Zstd) {
+#ifdef VCD_WITH_ZSTD
+            frames.clear();
+            if (!compressed.open(file) || !splitFrames()) return false;
+            decoders = frames.size() < (size_t)decodeThreads ? frames.size() : decodeThreads;
+            if (decoders == 0) decoders = 1;
+#else
+            fail("zstd input needs a build with -DVCD_WITH_ZSTD -lzstd");
+            return false;
+#endif
+        } else {
+            fail("not a gzip or zstd file");
+            return false;
+        }
+
+        for (size_t i = 0; i < decoders; ++i) queues.push_back(std::make_unique<spsc_queue<std::string>>(4));
+        for (size_t i = 0; i < decoders; ++i) {
+#ifndef VCD_NO_ZLIB
+            if (format == Gzip) workers.emplace_back([this] { decodeGzip(); });
+#endif
+#ifdef VCD_WITH_ZSTD
+            if (format == Zstd) workers.emplace_back([this, i] { decodeZstd(i); });
+#endif
+        }
+        return true;
+    }
+
+    Format fileFormat() const { return format; }
+
+    // Decompressed bytes read so far
+    uint64_t bytesDecoded() const { return decoded; }
+
+    // True when decoding stopped on an error; the input then ends early
+    bool hasFailed() const { return failed.load(); }
+
+    bool refill(const char* keep, const char*& begin, const char*& end) override {
+        while (finished < queues.size()) {
+            if (!queues[current]->pop(chunk)) {
+                // Frames are dealt round robin, so the first queue to run dry ends the input
+                finished = queues.size();
+                break;
+            }
+            if (chunk.empty()) {
+                current = (current + 1) % queues.size();
+                continue;
+            }
+
+            decoded += chunk.size();
+            size_t kept = keep == nullptr ? window.size() : keep - window.data();
+            if (kept == window.size()) window.swap(chunk);
+            else {
+                window.erase(0, kept);
+                window += chunk;
+            }
+            begin = window.data();
+            end = begin + window.size();
+            return true;
+        }
+        return false;
+    }
+};
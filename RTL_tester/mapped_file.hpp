@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file. The contents stay valid for the lifetime of the object,
+// so parsers can hand out std::string_view tokens into it without copying.
+class mapped_file {
+private:
+    const char* base = nullptr;
+    size_t length = 0;
+    bool opened = false;
+
+    void release() {
+        if (base != nullptr && length > 0) munmap(const_cast<char*>(base), length);
+        base = nullptr;
+        length = 0;
+        opened = false;
+    }
+
+public:
+    mapped_file() = default;
+    explicit mapped_file(const std::string& path) { open(path); }
+    ~mapped_file() { release(); }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    bool open(const std::string& path) {
+        release();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                length = 0;
+                return false;
+            }
+            madvise(p, length, MADV_SEQUENTIAL);
+            base = static_cast<const char*>(p);
+        }
+        ::close(fd);
+        opened = true;
+        return true;
+    }
+
+    bool is_open() const { return opened; }
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(base, length); }
+
+    // Lets the kernel drop the pages before upTo from the process; they are read back from the file
+    // if touched again. Keeps the resident size flat when a long file is consumed front to back.
+    void discard(const char* upTo) {
+        static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        if (base == nullptr || upTo <= base) return;
+        size_t bytes = static_cast<size_t>(upTo - base) / page * page;
+        if (bytes > 0) madvise(const_cast<char*>(base), bytes, MADV_DONTNEED);
+    }
+};
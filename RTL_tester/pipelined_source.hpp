@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_queue.hpp"
+
+// Runs an opened row source (a VCD converter) on its own thread and hands its rows over through a
+// bounded SPSC queue. It exposes the same columnNames()/nextRow() interface, so
+// signal_comparator::compareStreams() can consume two of these while both dumps are still being parsed.
+template <typename Source>
+class pipelined_source {
+public:
+    using value_type = typename Source::value_type;
+
+private:
+    Source& source;
+    spsc_queue<std::vector<value_type>> queue;
+    std::atomic<bool> cancelled{false};
+    std::thread worker;
+
+public:
+    explicit pipelined_source(Source& src, size_t depth = 1024) : source(src), queue(depth) {
+        worker = std::thread([this] {
+            std::vector<value_type> row;
+            while (source.nextRow(row)) {
+                if (!queue.push(row, cancelled)) break;
+            }
+            queue.close();
+        });
+    }
+
+    // Stops the producer if the consumer finished first (e.g. the other dump was shorter)
+    ~pipelined_source() {
+        cancelled.store(true);
+        worker.join();
+    }
+
+    pipelined_source(const pipelined_source&) = delete;
+    pipelined_source& operator=(const pipelined_source&) = delete;
+
+    const std::vector<std::string>& columnNames() const { return source.columnNames(); }
+    bool nextRow(std::vector<value_type>& row) { return queue.pop(row); }
+};
@@ -0,0 +1,133 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include "vcd_value.hpp"
+
+// RTL signals that make up one architectural commit. Names are full column names of the wrapped
+// source. The memory stage is optional; its events are buffered and attached to the commit with the
+// same PC, since the access happens some cycles before writeback.
+struct rtl_commit_signals {
+    std::string wbValid;     // commit when set; empty = commit whenever wbPc changes
+    std::string wbPc, wbRdAddr, wbRdData;
+    std::string memValid;    // memory access when set; empty = no memory columns
+    std::string memPc, memAddr, memData;
+    std::string memWrite;    // store when set; loads report data 0 like the Spike log. Empty = every access
+
+    // Signals the VCD converter has to select
+    std::set<std::string> names() const {
+        std::set<std::string> all;
+        for (const std::string* s : {&wbValid, &wbPc, &wbRdAddr, &wbRdData, &memValid, &memPc, &memAddr, &memData, &memWrite}) {
+            if (!s->empty()) all.insert(*s);
+        }
+        return all;
+    }
+};
+
+// Turns the per-cycle rows of a VCD converter into one row per committed instruction with the same
+// columns as spike_commit_source: writeback PC, rd, rd data (0 for x0 writes), memory address and data.
+// Column names are the RTL signal names, so reports read "spike.pc vs <rtl pc signal>".
+template <typename Source>
+class rtl_commit_source {
+public:
+    using value_type = typename Source::value_type;
+
+private:
+    struct MemoryEvent {
+        value_type pc, addr, data;
+    };
+
+    Source& source;
+    rtl_commit_signals sig;
+    std::vector<std::string> columns;
+    std::vector<value_type> cycleRow;
+    std::deque<MemoryEvent> memEvents;
+    value_type lastPc;
+    bool haveLastPc = false;
+    bool valid = false;
+    int wbValid = -1, wbPc = -1, wbRdAddr = -1, wbRdData = -1;
+    int memValid = -1, memPc = -1, memAddr = -1, memData = -1, memWrite = -1;
+
+    static constexpr size_t maxMemEvents = 64;
+
+    static bool isAsserted(const value_type& v) { return v.isKnown() && !v.isZero(); }
+
+public:
+    rtl_commit_source(Source& src, rtl_commit_signals signals) : source(src), sig(signals) {
+        std::map<std::string, int> idx;
+        const std::vector<std::string>& names = source.columnNames();
+        for (size_t i = 0; i < names.size(); ++i) idx.emplace(names[i], (int)i);
+        auto find = [&](const std::string& name, int& col) {
+            if (name.empty()) return true;
+            auto it = idx.find(name);
+            if (it == idx.end()) {
+                std::cerr << "Error: commit signal " << name << " not found." << std::endl;
+                return false;
+            }
+            col = it->second;
+            return true;
+        };
+        valid = find(sig.wbValid, wbValid) && find(sig.wbPc, wbPc) && find(sig.wbRdAddr, wbRdAddr) &&
+                find(sig.wbRdData, wbRdData) && wbPc >= 0 && wbRdAddr >= 0 && wbRdData >= 0;
+        if (!sig.memValid.empty()) {
+            valid = valid && find(sig.memValid, memValid) && find(sig.memPc, memPc) && find(sig.memAddr, memAddr) &&
+                    find(sig.memData, memData) && find(sig.memWrite, memWrite);
+        }
+
+        columns = {sig.wbPc, sig.wbRdAddr, sig.wbRdData};
+        if (memValid >= 0) {
+            columns.push_back(sig.memAddr);
+            columns.push_back(sig.memData);
+        }
+    }
+
+    // False when a configured signal is missing from the source
+    bool isValid() const { return valid; }
+
+    const std::vector<std::string>& columnNames() const { return columns; }
+
+    bool nextRow(std::vector<value_type>& row) {
+        if (!valid) return false;
+        while (source.nextRow(cycleRow)) {
+            if (memValid >= 0 && isAsserted(cycleRow[memValid])) {
+                if (memEvents.size() == maxMemEvents) memEvents.pop_front();
+                MemoryEvent ev{cycleRow[memPc], cycleRow[memAddr], cycleRow[memData]};
+                if (memWrite >= 0 && !isAsserted(cycleRow[memWrite])) ev.data.assignUnsigned(0);
+                memEvents.push_back(ev);
+            }
+
+            bool commit;
+            if (wbValid >= 0) commit = isAsserted(cycleRow[wbValid]);
+            else {
+                commit = !haveLastPc || cycleRow[wbPc] != lastPc;
+                lastPc = cycleRow[wbPc];
+                haveLastPc = true;
+            }
+            if (!commit) continue;
+
+            row.resize(columns.size());
+            row[0] = cycleRow[wbPc];
+            row[1] = cycleRow[wbRdAddr];
+            row[2] = cycleRow[wbRdData];
+            if (row[1].isZero()) row[2].assignUnsigned(0);
+            if (memValid >= 0) {
+                // The access of this instruction; older unmatched events were squashed in the pipeline
+                size_t m = 0;
+                while (m < memEvents.size() && memEvents[m].pc != row[0]) ++m;
+                if (m < memEvents.size()) {
+                    row[3] = memEvents[m].addr;
+                    row[4] = memEvents[m].data;
+                    memEvents.erase(memEvents.begin(), memEvents.begin() + m + 1);
+                } else {
+                    row[3].assignUnsigned(0);
+                    row[4].assignUnsigned(0);
+                }
+            }
+            return true;
+        }
+        return false;
+    }
+};
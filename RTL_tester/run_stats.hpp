@@ -0,0 +1,280 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+// Counters and phase times of one stage of a run: a converter, the comparator, the Spike merge.
+// The stage keeps its counts in plain members and publishes them here with relaxed stores once per
+// row, so the hot loops pay nothing per value change; run_stats reads them from its own thread.
+class stage_stats {
+public:
+    enum Counter { Bytes, Lines, ValueChanges, Rows, CounterCount };
+    static constexpr const char* counterNames[CounterCount] = {"bytes_read", "lines", "value_changes", "rows"};
+
+    // Wall time, CPU time and major page faults (reads from disk) at one point, of the calling thread or
+    // of the whole process
+    struct mark {
+        std::chrono::steady_clock::time_point wall;
+        double cpu = 0;
+        long majorFaults = 0;
+
+        static mark now(bool allThreads = false) {
+            mark m;
+            m.wall = std::chrono::steady_clock::now();
+            rusage ru{};
+#ifdef RUSAGE_THREAD
+            getrusage(allThreads ? RUSAGE_SELF : RUSAGE_THREAD, &ru);
+#else
+            getrusage(RUSAGE_SELF, &ru);
+#endif
+            m.cpu = ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1e-6;
+            m.majorFaults = ru.ru_majflt;
+            return m;
+        }
+    };
+
+    // Wall time well above CPU time means the stage waited: on page faults of a mapped input, on the
+    // decoder threads of a compressed one, or on the other side of a queue
+    struct Phase {
+        std::string name;
+        double wallSeconds = 0;
+        double cpuSeconds = 0;
+        long majorFaults = 0;
+        bool allThreads = false;
+    };
+
+    // Adds its lifetime to a phase of stage; nothing is measured for a null stage
+    class timer {
+    private:
+        stage_stats* stage;
+        const char* name;
+        bool allThreads;
+        mark start;
+
+    public:
+        timer(stage_stats* s, const char* phase, bool wholeProcess = false) : stage(s), name(phase), allThreads(wholeProcess) {
+            if (stage != nullptr) start = mark::now(allThreads);
+        }
+        ~timer() {
+            if (stage != nullptr) stage->addPhase(name, start, allThreads);
+        }
+        timer(const timer&) = delete;
+        timer& operator=(const timer&) = delete;
+    };
+
+private:
+    std::string stageName;
+    std::atomic<uint64_t> counters[CounterCount] = {};
+    std::atomic<uint64_t> expectedBytes{0};
+    std::atomic<bool> finished{false};
+    mutable std::mutex phaseLock;
+    std::vector<Phase> phases;
+
+public:
+    explicit stage_stats(std::string name) : stageName(std::move(name)) {}
+
+    const std::string& name() const { return stageName; }
+
+    void set(Counter c, uint64_t value) { counters[c].store(value, std::memory_order_relaxed); }
+    uint64_t get(Counter c) const { return counters[c].load(std::memory_order_relaxed); }
+
+    // Size of the input, for the percentage in progress lines (0 = unknown, e.g. a compressed dump)
+    void setTotalBytes(uint64_t bytes) { expectedBytes.store(bytes, std::memory_order_relaxed); }
+    uint64_t totalBytes() const { return expectedBytes.load(std::memory_order_relaxed); }
+
+    // No more progress lines for this stage
+    void finish() { finished.store(true, std::memory_order_relaxed); }
+    bool isFinished() const { return finished.load(std::memory_order_relaxed); }
+
+    // Time since start, added to the phase of that name
+    void addPhase(const char* phase, const mark& start, bool allThreads = false) {
+        mark end = mark::now(allThreads);
+        std::lock_guard<std::mutex> g(phaseLock);
+        Phase* p = nullptr;
+        for (Phase& existing : phases) {
+            if (existing.name == phase) p = &existing;
+        }
+        if (p == nullptr) {
+            phases.emplace_back();
+            p = &phases.back();
+            p->name = phase;
+            p->allThreads = allThreads;
+        }
+        p->wallSeconds += std::chrono::duration<double>(end.wall - start.wall).count();
+        p->cpuSeconds += end.cpu - start.cpu;
+        p->majorFaults += end.majorFaults - start.majorFaults;
+    }
+
+    std::vector<Phase> phaseTimes() const {
+        std::lock_guard<std::mutex> g(phaseLock);
+        return phases;
+    }
+};
+
+// The stages of one run. Every interval a progress line per unfinished stage goes to stderr (bytes of
+// the input, value changes, rows and their rates), and writeJson() dumps all counters, phase times and
+// the peak resident memory of the process at the end.
+class run_stats {
+private:
+    std::deque<stage_stats> stages;
+    mutable std::mutex stagesLock;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    std::thread reporter;
+    std::mutex reporterLock;
+    std::condition_variable reporterWake;
+    bool stopping = false;
+
+    static void appendQuoted(std::string& out, const std::string& s) {
+        out += '"';
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            out += c;
+        }
+        out += '"';
+    }
+
+    static void appendNumber(std::string& out, double v, const char* format = "%.6f") {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), format, v);
+        out += buf;
+    }
+
+    // last: bytes and value changes per stage at the previous report, for the rates
+    void report(std::ostream& os, std::vector<uint64_t>& last, double interval) {
+        std::string lines;
+        char buf[160];
+        std::lock_guard<std::mutex> g(stagesLock);
+        last.resize(2 * stages.size());
+        for (size_t i = 0; i < stages.size(); ++i) {
+            const stage_stats& st = stages[i];
+            uint64_t bytes = st.get(stage_stats::Bytes), changes = st.get(stage_stats::ValueChanges);
+            uint64_t lineCount = st.get(stage_stats::Lines), rows = st.get(stage_stats::Rows);
+            double byteRate = (bytes - last[2 * i]) / interval, changeRate = (changes - last[2 * i + 1]) / interval;
+            last[2 * i] = bytes;
+            last[2 * i + 1] = changes;
+            if (st.isFinished() || bytes + changes + lineCount + rows == 0) continue;
+
+            std::vector<std::string> parts;
+            if (bytes > 0) {
+                std::snprintf(buf, sizeof(buf), "%.1f MB", bytes / 1048576.0);
+                std::string part = buf;
+                if (st.totalBytes() > 0) {
+                    std::snprintf(buf, sizeof(buf), " of %.1f MB (%.1f%%)", st.totalBytes() / 1048576.0, 100.0 * bytes / st.totalBytes());
+                    part += buf;
+                }
+                std::snprintf(buf, sizeof(buf), " at %.1f MB/s", byteRate / 1048576.0);
+                parts.push_back(part + buf);
+            }
+            if (lineCount > 0) parts.push_back(std::to_string(lineCount) + " lines");
+            if (changes > 0) {
+                std::snprintf(buf, sizeof(buf), "%llu value changes (%.0f/s)", (unsigned long long)changes, changeRate);
+                parts.push_back(buf);
+            }
+            if (rows > 0) parts.push_back(std::to_string(rows) + " rows");
+
+            std::snprintf(buf, sizeof(buf), "[Progress %.0fs] %s: ", elapsed(), st.name().c_str());
+            lines += buf;
+            for (size_t p = 0; p < parts.size(); ++p) lines += (p == 0 ? "" : ", ") + parts[p];
+            lines += '\n';
+        }
+        if (lines.empty()) return;
+        std::snprintf(buf, sizeof(buf), "[Progress %.0fs] peak RSS %.1f MB\n", elapsed(), peakRssBytes() / 1048576.0);
+        os << lines << buf << std::flush;
+    }
+
+public:
+    run_stats() = default;
+    ~run_stats() { stopProgress(); }
+
+    run_stats(const run_stats&) = delete;
+    run_stats& operator=(const run_stats&) = delete;
+
+    // A new stage; the reference stays valid for the lifetime of run_stats
+    stage_stats& add(const std::string& name) {
+        std::lock_guard<std::mutex> g(stagesLock);
+        stages.emplace_back(name);
+        return stages.back();
+    }
+
+    double elapsed() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count(); }
+
+    // Largest resident set of the process so far
+    static uint64_t peakRssBytes() {
+        rusage ru{};
+        getrusage(RUSAGE_SELF, &ru);
+        return (uint64_t)ru.ru_maxrss * 1024;
+    }
+
+    // Progress lines every seconds (<= 0: none) until stopProgress()
+    void startProgress(double seconds, std::ostream& os = std::cerr) {
+        if (seconds <= 0 || reporter.joinable()) return;
+        stopping = false;
+        reporter = std::thread([this, seconds, &os] {
+            std::vector<uint64_t> last;
+            auto interval = std::chrono::duration<double>(seconds);
+            std::unique_lock<std::mutex> lk(reporterLock);
+            while (!reporterWake.wait_for(lk, interval, [this] { return stopping; })) report(os, last, seconds);
+        });
+    }
+
+    void stopProgress() {
+        if (!reporter.joinable()) return;
+        {
+            std::lock_guard<std::mutex> g(reporterLock);
+            stopping = true;
+        }
+        reporterWake.notify_all();
+        reporter.join();
+    }
+
+    bool writeJson(const std::string& path) const {
+        std::string o = "{\n  \"wall_seconds\": ";
+        appendNumber(o, elapsed());
+        o += ",\n  \"peak_rss_bytes\": " + std::to_string(peakRssBytes()) + ",\n  \"stages\": [";
+        {
+            std::lock_guard<std::mutex> g(stagesLock);
+            for (size_t i = 0; i < stages.size(); ++i) {
+                const stage_stats& st = stages[i];
+                o += i == 0 ? "\n    {\"name\": " : ",\n    {\"name\": ";
+                appendQuoted(o, st.name());
+                for (int c = 0; c < stage_stats::CounterCount; ++c) {
+                    o += std::string(", \"") + stage_stats::counterNames[c] + "\": " + std::to_string(st.get((stage_stats::Counter)c));
+                }
+                if (st.totalBytes() > 0) o += ", \"total_bytes\": " + std::to_string(st.totalBytes());
+                o += ", \"phases\": [";
+                std::vector<stage_stats::Phase> phases = st.phaseTimes();
+                for (size_t p = 0; p < phases.size(); ++p) {
+                    o += p == 0 ? "\n      {\"name\": " : ",\n      {\"name\": ";
+                    appendQuoted(o, phases[p].name);
+                    o += ", \"wall_seconds\": ";
+                    appendNumber(o, phases[p].wallSeconds);
+                    o += ", \"cpu_seconds\": ";
+                    appendNumber(o, phases[p].cpuSeconds);
+                    o += std::string(", \"cpu_of\": \"") + (phases[p].allThreads ? "process" : "thread") + "\"";
+                    o += ", \"major_faults\": " + std::to_string(phases[p].majorFaults) + "}";
+                }
+                o += phases.empty() ? "]}" : "\n    ]}";
+            }
+        }
+        o += "\n  ]\n}\n";
+
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not write " << path << std::endl;
+            return false;
+        }
+        file << o;
+        return (bool)file;
+    }
+};
@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "spsc_queue.hpp"
+
+// Runs an opened row source (a VCD converter) on its own thread for several consumers, so a dump that
+// several comparisons read is parsed once. Every output is a columnNames()/nextRow() source of its own
+// with a bounded SPSC queue, for a comparator on another thread, and gets a copy of every row. With
+// sample domains there is one output per domain instead, with the rows of that domain.
+//
+// A consumer usually reads a second source as well, so one output may fall far behind another: the
+// producer waits on a full queue only while no other output's consumer waits for a row. Otherwise the
+// row goes to an unbounded spill list of that output, which its consumer reads once the queue is empty.
+template <typename Source>
+class shared_source {
+public:
+    class output {
+    public:
+        using value_type = typename Source::value_type;
+
+    private:
+        friend class shared_source;
+        spsc_queue<std::vector<value_type>> queue;
+        std::vector<std::string> columns;
+        std::atomic<bool> detached{false};
+        std::atomic<bool> waiting{false};           // the consumer found nothing queued and waits
+        std::mutex spillLock;
+        std::deque<std::vector<value_type>> spill;  // rows queued after the queue was full, oldest first
+        std::atomic<size_t> spilled{0};
+
+        // With spillLock held
+        void popSpilled(std::vector<value_type>& row) {
+            std::swap(row, spill.front());
+            spill.pop_front();
+            spilled.fetch_sub(1, std::memory_order_release);
+        }
+
+        bool takeSpilled(std::vector<value_type>& row) {
+            if (spilled.load(std::memory_order_acquire) == 0) return false;
+            std::lock_guard<std::mutex> lock(spillLock);
+            popSpilled(row);
+            return true;
+        }
+
+    public:
+        output(size_t depth, const std::vector<std::string>& names) : queue(depth), columns(names) {}
+
+        const std::vector<std::string>& columnNames() const { return columns; }
+
+        // The producer fills the queue only while nothing is spilled, so queued rows come first. waiting
+        // is raised under spillLock once the spill list is seen empty, so the producer does not spill
+        // past a consumer that waits on the queue.
+        bool nextRow(std::vector<value_type>& row) {
+            if (queue.tryPop(row) || takeSpilled(row)) return true;
+            {
+                std::lock_guard<std::mutex> lock(spillLock);
+                if (!spill.empty()) {
+                    popSpilled(row);
+                    return true;
+                }
+                waiting.store(true);
+            }
+            bool got = queue.pop(row);
+            waiting.store(false);
+            return got || takeSpilled(row);
+        }
+
+        // The consumer is done, e.g. stopped early: its rows are dropped instead of filling the queue
+        // and holding up the other outputs. Call once the comparison reading this output returns.
+        void detach() { detached.store(true); }
+    };
+
+private:
+    Source& source;
+    std::deque<output> outputs;
+    std::thread worker;
+
+    bool allDetached() const {
+        for (const output& o : outputs) {
+            if (!o.detached.load(std::memory_order_relaxed)) return false;
+        }
+        return true;
+    }
+
+    bool otherWaiting(const output& skip) const {
+        for (const output& o : outputs) {
+            if (&o != &skip && o.waiting.load() && !o.detached.load(std::memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+
+    void put(output& o, std::vector<typename Source::value_type>& row) {
+        for (;;) {
+            if (o.detached.load(std::memory_order_relaxed)) return;
+            bool full = false;
+            if (o.spilled.load(std::memory_order_acquire) == 0) {
+                if (o.queue.push(row, [&] { return o.detached.load(std::memory_order_relaxed) || otherWaiting(o); })) return;
+                full = true;
+            }
+            // Spill behind earlier spilled rows, or past a full queue unless its consumer has emptied it
+            // since and waits; otherwise go back to the queue
+            std::lock_guard<std::mutex> lock(o.spillLock);
+            if (!o.spill.empty() || (full && !o.waiting.load())) {
+                o.spill.push_back(std::move(row));
+                o.spilled.fetch_add(1, std::memory_order_release);
+                return;
+            }
+        }
+    }
+
+public:
+    // consumers is ignored when the source has sample domains
+    shared_source(Source& src, size_t consumers, size_t depth = 1024) : source(src) {
+        size_t domains = source.domainCount();
+        for (size_t d = 0; d < domains; ++d) outputs.emplace_back(depth, source.domainColumns(d));
+        for (size_t i = 0; domains == 0 && i < consumers; ++i) outputs.emplace_back(depth, source.columnNames());
+        worker = std::thread([this, domains] {
+            std::vector<typename Source::value_type> row, copy;
+            size_t d;
+            while (domains > 0 && !allDetached() && source.nextDomainRow(row, d)) put(outputs[d], row);
+            while (domains == 0 && !allDetached() && source.nextRow(row)) {
+                for (size_t i = 0; i < outputs.size(); ++i) {
+                    if (i + 1 == outputs.size()) {
+                        put(outputs[i], row);
+                    } else {
+                        copy = row;
+                        put(outputs[i], copy);
+                    }
+                }
+            }
+            for (output& o : outputs) o.queue.close();
+        });
+    }
+
+    ~shared_source() {
+        for (output& o : outputs) o.detach();
+        worker.join();
+    }
+
+    shared_source(const shared_source&) = delete;
+    shared_source& operator=(const shared_source&) = delete;
+
+    output& at(size_t index) { return outputs[index]; }
+    size_t size() const { return outputs.size(); }
+};
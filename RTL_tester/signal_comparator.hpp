@@ -1,9 +1,18 @@
+#pragma once
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <vector>
 #include <sstream>
 #include <map>
+#include <deque>
+#include <cstdio>
+#include <string_view>
+#include <functional>
+#include "mapped_file.hpp"
+#include "vcd_trace_file.hpp"
+#include "vcd_checkpoint.hpp"
+#include "run_stats.hpp"
 
 class signal_comparator {
 public:
@@ -22,66 +31,603 @@ public:
         return tokens;
     }
 
+    // Where reports and mismatch lines go (std::cout by default), e.g. a per-hart buffer when several
+    // comparators run on their own threads
+    void setOutput(std::ostream& os) { out = &os; }
+
+    // Stop once maxMismatches values have mismatched (0 = compare everything) and print windowCycles
+    // cycles of every compared pair before and after the first divergence
+    void setEarlyAbort(long maxMismatches, int windowCycles = 3) {
+        stopAfter = maxMismatches;
+        window = windowCycles;
+    }
+
+    // Compare committed instructions instead of raw cycles. Each side is reduced to commit events:
+    // rows where its valid signal is set or, without a valid signal, rows where the key signal changes.
+    // The two event streams are matched on the key value; when they disagree, up to lookAhead events
+    // on each side are searched for the nearest point where they line up again, and the skipped
+    // events are reported as inserted/missing instead of turning every later row into a mismatch.
+    void setAlignment(std::string keySignal1, std::string keySignal2, int lookAhead = 16,
+                      std::string validSignal1 = "", std::string validSignal2 = "") {
+        alignKey1 = keySignal1;
+        alignKey2 = keySignal2;
+        alignValid1 = validSignal1;
+        alignValid2 = validSignal2;
+        alignLookAhead = lookAhead;
+    }
+
+    // Only check cycles firstCycle..lastCycle (lastCycle < 0 = to the end). Earlier rows are still read,
+    // but nothing is checked, logged or kept for the divergence window.
+    void setCycleRange(int firstCycle, int lastCycle = -1) {
+        rangeFirst = firstCycle;
+        rangeLast = lastCycle;
+    }
+
+    // Every everyCycles cycles of a lockstep compareStreams(), write a checkpoint to path: saveSources
+    // adds the parse state of both inputs (e.g. the converters' saveState()) and the comparator adds its
+    // cycle, mismatch count and per-pair Stats. Aligned comparisons read the inputs ahead of the compared
+    // commit, so they refuse to start with a checkpoint or resume set. Pipelined inputs run ahead as
+    // well and must not be checkpointed either.
+    void setCheckpoint(std::string path, int everyCycles, std::function<void(vcd_checkpoint&)> saveSources) {
+        checkpointPath = path;
+        checkpointEvery = everyCycles;
+        checkpointSources = saveSources;
+    }
+
+    // Continue the counters of a checkpointed comparison. The inputs are restored from the same
+    // checkpoint by the caller before compareStreams(); the report then covers the whole dump.
+    void resumeFrom(const vcd_checkpoint& cp) {
+        resumed = true;
+        resumeCycle = (int)cp.getNumber("compare.cycle");
+        resumeMismatches = cp.getNumber("compare.mismatches");
+        resumeStats.clear();
+        for (const auto& [key, value] : cp.section("compare.stat.")) {
+            Stats st;
+            size_t sp = value.find(' ');
+            st.checks = std::stol(value.substr(0, sp));
+            if (sp != std::string::npos) st.mismatches = std::stol(value.substr(sp + 1));
+            resumeStats[key] = st;
+        }
+    }
+
     void compare(std::string file1, std::string file2, std::map<std::string, std::string> signalMapping) {
-        std::ifstream f1(file1), f2(file2);
-        std::string line1, line2;
+        mapped_file f1(file1), f2(file2);
 
         if (!f1.is_open() || !f2.is_open()) {
             std::cerr << "Error opening CSV files." << std::endl;
             return;
         }
 
-        std::getline(f1, line1);
-        std::getline(f2, line2);
-        std::vector<std::string> header1 = split(line1, ',');
-        std::vector<std::string> header2 = split(line2, ',');
+        // Rows are scanned in place: fields are views into the mapped files
+        std::string_view text1 = f1.view(), text2 = f2.view();
+        std::string_view line1, line2;
+        nextLine(text1, line1);
+        nextLine(text2, line2);
+        std::vector<std::string> header1 = split(std::string(line1), ',');
+        std::vector<std::string> header2 = split(std::string(line2), ',');
+
+        std::vector<std::string_view> data1, data2;
+        uint64_t lines = 0;
+        if (stageStats != nullptr) stageStats->setTotalBytes(f1.size() + f2.size());
+        compareRows(header1, header2, data1, data2, signalMapping,
+            [&]() {
+                if (!nextLine(text1, line1)) return false;
+                splitFields(line1, data1, header1.size());
+                return true;
+            },
+            [&]() {
+                if (!nextLine(text2, line2)) return false;
+                splitFields(line2, data2, header2.size());
+                if (stageStats != nullptr) {
+                    stageStats->set(stage_stats::Bytes, f1.size() - text1.size() + f2.size() - text2.size());
+                    stageStats->set(stage_stats::Lines, 2 * ++lines);
+                }
+                return true;
+            });
+    }
+
+    // Lockstep comparison of two row sources (e.g. opened VCD converters) without a CSV round-trip.
+    // Sources provide columnNames(), a value_type and nextRow(std::vector<value_type>&); only one row of each
+    // is held in memory. Values are compared directly and only turned into text for mismatch lines.
+    template <typename SourceA, typename SourceB>
+    void compareStreams(SourceA& src1, SourceB& src2, std::map<std::string, std::string> signalMapping) {
+        std::vector<typename SourceA::value_type> data1;
+        std::vector<typename SourceB::value_type> data2;
+        compareRows(src1.columnNames(), src2.columnNames(), data1, data2, signalMapping,
+                    [&]() { return src1.nextRow(data1); }, [&]() { return src2.nextRow(data2); });
+    }
+
+    // Compares two binary traces written by the converters' setTraceOutput(); both files are mapped
+    // and read block by block, with no text parsing
+    void compareTraces(std::string file1, std::string file2, std::map<std::string, std::string> signalMapping) {
+        vcd_trace_reader trace1, trace2;
+        if (!trace1.open(file1) || !trace2.open(file2)) {
+            std::cerr << "Error opening trace files." << std::endl;
+            return;
+        }
+        compareStreams(trace1, trace2, signalMapping);
+    }
+
+    // Publish compared rows (and bytes read of CSV inputs) to stage, and time the compare and report
+    // phases. In lockstep streaming the compare phase includes pulling rows from the inputs.
+    void setStats(stage_stats* stage) { stageStats = stage; }
+
+    // Cycles (commits when aligned), mismatches, unmatched commits (in lockstep, rows past the end of
+    // the shorter input) and per-pair counts of the last finished comparison; pairStats() is empty if
+    // it could not start or no mapped pair was found
+    int cyclesCompared() const { return reportedCycles; }
+    long mismatchCount() const { return totalMismatches; }
+    long unmatchedCount() const { return reportedUnmatched; }
+    const std::map<std::string, Stats>& pairStats() const { return reportedStats; }
+    // 1 or 2 when that input ran out of rows before the other in lockstep mode, else 0
+    int inputEndedFirst() const { return endedFirst; }
+    // False when the last comparison could not start, compared nothing or one input ended first
+    bool complete() const { return !reportedStats.empty() && reportedCycles > 0 && endedFirst == 0; }
+
+private:
+    std::ostream* out = &std::cout;
+    long stopAfter = 0;
+    int window = 0;
+    long totalMismatches = 0;
+    int reportedCycles = 0;
+    long reportedUnmatched = 0;
+    int endedFirst = 0;
+    std::map<std::string, Stats> reportedStats;
+    std::ostringstream mismatchLog;
+    std::string alignKey1, alignKey2, alignValid1, alignValid2;
+    int alignLookAhead = 16;
+    int rangeFirst = 0;
+    int rangeLast = -1;
+    std::string checkpointPath;
+    int checkpointEvery = 0;
+    std::function<void(vcd_checkpoint&)> checkpointSources;
+    bool resumed = false;
+    int resumeCycle = 0;
+    long resumeMismatches = 0;
+    std::map<std::string, Stats> resumeStats;
+    stage_stats* stageStats = nullptr;
+
+    // Values of every compared pair at one cycle, kept for the divergence window. cycle2 is the
+    // second stream's cycle when commits are aligned, -1 in lockstep mode.
+    struct WindowRow {
+        int cycle = 0;
+        int cycle2 = -1;
+        std::vector<std::string> val1, val2;
+        std::vector<char> differs;
+    };
+
+    // Mapping resolved against both headers: one entry per signal pair present in both
+    struct PlannedCheck {
+        int col1, col2;
+        size_t stat;
+    };
+
+    // State of the current comparison run
+    std::vector<PlannedCheck> plan;
+    std::vector<std::string> pairNames;
+    std::vector<Stats> stats;
+    std::deque<WindowRow> before;
+    std::vector<WindowRow> after;
+    int firstDivergence = -1;
+    int firstDivergence2 = -1;
+    int divergentRows = 0;      // 1 when after starts with the first mismatching row, 0 after an alignment skip
+
+    // One side of the commit alignment: rows reduced to commit events, buffered up to the look-ahead
+    template <typename Value>
+    struct EventQueue {
+        int key = -1;
+        int valid = -1;
+        std::deque<int> cycles;
+        std::deque<std::vector<Value>> rows;
+        std::vector<std::vector<Value>> spare;    // recycled row buffers
+        Value lastKey{};
+        bool haveLast = false;
+        bool ended = false;
+        int rowsRead = 0;
+
+        // Reads rows until the next commit event is queued
+        template <typename Fetch>
+        bool pull(Fetch& fetch, const std::vector<Value>& data) {
+            while (fetch()) {
+                int cyc = rowsRead++;
+                bool isEvent;
+                if (valid >= 0) isEvent = isAsserted(data[valid]);
+                else {
+                    isEvent = !haveLast || data[key] != lastKey;
+                    lastKey = data[key];
+                    haveLast = true;
+                }
+                if (!isEvent) continue;
+
+                if (spare.empty()) rows.push_back(data);
+                else {
+                    rows.push_back(std::move(spare.back()));
+                    spare.pop_back();
+                    rows.back() = data;
+                }
+                cycles.push_back(cyc);
+                return true;
+            }
+            return false;
+        }
+
+        void pop() {
+            spare.push_back(std::move(rows.front()));
+            rows.pop_front();
+            cycles.pop_front();
+        }
+    };
+
+    static bool isAsserted(std::string_view v) {
+        return !v.empty() && v != "0" && v.find_first_not_of("0123456789") == std::string_view::npos;
+    }
+
+    template <typename Value>
+    static bool isAsserted(const Value& v) { return v.isKnown() && !v.isZero(); }
+
+    void writeCycle(std::ostream& os, int cycle, int cycle2) {
+        os << "Cyc " << cycle;
+        if (cycle2 >= 0) os << "/" << cycle2;
+    }
+
+    // Same line semantics as std::getline: a trailing newline does not start an empty last line
+    static bool nextLine(std::string_view& text, std::string_view& line) {
+        if (text.empty()) return false;
+        size_t nl = text.find('\n');
+        line = text.substr(0, nl);
+        text = (nl == std::string_view::npos) ? std::string_view() : text.substr(nl + 1);
+        return true;
+    }
+
+    // Fills fields in place (no allocation once the vector has grown); short rows are padded with
+    // empty fields up to the header width
+    static void splitFields(std::string_view line, std::vector<std::string_view>& fields, size_t columns) {
+        fields.clear();
+        size_t pos = 0;
+        for (;;) {
+            size_t comma = line.find(',', pos);
+            if (comma == std::string_view::npos) {
+                if (pos < line.size()) fields.push_back(line.substr(pos));
+                break;
+            }
+            fields.push_back(line.substr(pos, comma - pos));
+            pos = comma + 1;
+        }
+        if (fields.size() < columns) fields.resize(columns);
+    }
+
+    template <typename... Args>
+    void writeFormatted(const char* format, Args... args) {
+        char buf[512];
+        int n = snprintf(buf, sizeof(buf), format, args...);
+        if (n < (int)sizeof(buf)) {
+            *out << buf;
+            return;
+        }
+        std::string wide(n + 1, '\0');
+        snprintf(&wide[0], wide.size(), format, args...);
+        wide.pop_back();
+        *out << wide;
+    }
+
+    void flushMismatchLog() {
+        *out << mismatchLog.str();
+        mismatchLog.str("");
+    }
 
+    // nextCycle is the first cycle the restored comparison will check. Pair names contain spaces, so
+    // the stats keys use the first signal of the pair; the mapping is keyed on it anyway.
+    void saveCheckpoint(int nextCycle) {
+        vcd_checkpoint cp;
+        checkpointSources(cp);
+        cp.set("compare.cycle", nextCycle);
+        cp.set("compare.mismatches", totalMismatches);
+        for (size_t i = 0; i < plan.size(); ++i) {
+            cp.set("compare.stat." + pairNames[i].substr(0, pairNames[i].find(' ')),
+                   std::to_string(stats[i].checks) + " " + std::to_string(stats[i].mismatches));
+        }
+        flushMismatchLog();
+        cp.save(checkpointPath);
+    }
+
+    // Shared entry point: fetch1()/fetch2() load the next row of each side into data1/data2
+    template <typename ValueA, typename ValueB, typename FetchA, typename FetchB>
+    void compareRows(const std::vector<std::string>& header1, const std::vector<std::string>& header2,
+                     std::vector<ValueA>& data1, std::vector<ValueB>& data2,
+                     const std::map<std::string, std::string>& signalMapping, FetchA fetch1, FetchB fetch2) {
+        if (!alignKey1.empty() && (!checkpointPath.empty() || resumed)) {
+            std::cerr << "Error: checkpoints and resuming are not supported with commit alignment." << std::endl;
+            return;
+        }
         std::map<std::string, int> idx1, idx2;
         for (int i = 0; i < (int)header1.size(); ++i) idx1[header1[i]] = i;
         for (int i = 0; i < (int)header2.size(); ++i) idx2[header2[i]] = i;
 
-        // Map to track stats per signal pair
-        std::map<std::string, Stats> reportCard;
-        int cycle = 0;
+        // Resolve names, columns and stats slots once; the row loop only indexes
+        plan.clear();
+        pairNames.clear();
+        stats.clear();
+        for (auto const& [sig1, sig2] : signalMapping) {
+            if (idx1.count(sig1) && idx2.count(sig2)) {
+                plan.push_back({idx1[sig1], idx2[sig2], stats.size()});
+                pairNames.push_back(sig1 + " vs " + sig2);
+                stats.emplace_back();
+            }
+        }
+        before.clear();
+        after.clear();
+        firstDivergence = firstDivergence2 = -1;
+        divergentRows = 0;
+        endedFirst = 0;
+        totalMismatches = resumeMismatches;
+        for (size_t i = 0; i < plan.size(); ++i) {
+            auto it = resumeStats.find(pairNames[i].substr(0, pairNames[i].find(' ')));
+            if (it != resumeStats.end()) stats[i] = it->second;
+        }
+
+        if (!alignKey1.empty()) {
+            if (!idx1.count(alignKey1) || !idx2.count(alignKey2) ||
+                (!alignValid1.empty() && !idx1.count(alignValid1)) || (!alignValid2.empty() && !idx2.count(alignValid2))) {
+                std::cerr << "Error: alignment signals not found in both inputs." << std::endl;
+                return;
+            }
+            EventQueue<ValueA> events1;
+            EventQueue<ValueB> events2;
+            events1.key = idx1[alignKey1];
+            events2.key = idx2[alignKey2];
+            if (!alignValid1.empty()) events1.valid = idx1[alignValid1];
+            if (!alignValid2.empty()) events2.valid = idx2[alignValid2];
+            compareAligned(events1, events2, data1, data2, fetch1, fetch2);
+            return;
+        }
+
+        int cycle = resumeCycle;
+        bool stopped = false;
+        bool checkpoints = !checkpointPath.empty() && checkpointEvery > 0 && checkpointSources;
+        stage_stats::mark compareStart = stage_stats::mark::now();
+
+        bool more1 = false, more2 = false;
+        for (;;) {
+            more1 = fetch1();
+            more2 = fetch2();
+            if (!more1 || !more2) break;
+            if (stageStats != nullptr) stageStats->set(stage_stats::Rows, cycle + 1);
+            if (cycle < rangeFirst) {
+                cycle++;
+                continue;
+            }
+            if (rangeLast >= 0 && cycle > rangeLast) break;
+            long found = checkRow(cycle, -1, data1, data2);
+            stopped = recordRow(found, cycle, -1, data1, data2);
+            cycle++;
+            if (stopped) break;
+            if (checkpoints && cycle % checkpointEvery == 0) saveCheckpoint(cycle);
+        }
+
+        // Finish the window past the stop point without counting those cycles
+        for (int extra = cycle; stopped && windowOpen() && fetch1() && fetch2(); ++extra) {
+            after.push_back(snapshot(extra, -1, data1, data2));
+        }
+        // One input ran out first within the range: the rows left on the other side are unmatched
+        long only1 = 0, only2 = 0;
+        if (!stopped && more1 != more2 && (rangeLast < 0 || cycle <= rangeLast)) {
+            endedFirst = more1 ? 2 : 1;
+            long& left = more1 ? only1 : only2;
+            left = 1;
+            while (more1 ? fetch1() : fetch2()) left++;
+            totalMismatches += left;
+            mismatchLog << "[Length] Cyc " << cycle << ": " << (more1 ? "second" : "first") << " input ended, "
+                        << left << " rows left in the " << (more1 ? "first" : "second") << " input\n";
+        }
+        if (stageStats != nullptr) stageStats->addPhase("compare", compareStart);
 
-        while (std::getline(f1, line1) && std::getline(f2, line2)) {
-            std::vector<std::string> data1 = split(line1, ',');
-            std::vector<std::string> data2 = split(line2, ',');
+        finishReport(cycle, stopped, only1, only2);
+    }
 
-            for (auto const& [sig1, sig2] : signalMapping) {
-                if (idx1.count(sig1) && idx2.count(sig2)) {
-                    std::string key = sig1 + " vs " + sig2;
-                    reportCard[key].checks++;
+    template <typename ValueA, typename ValueB, typename FetchA, typename FetchB>
+    void compareAligned(EventQueue<ValueA>& events1, EventQueue<ValueB>& events2,
+                        std::vector<ValueA>& data1, std::vector<ValueB>& data2, FetchA& fetch1, FetchB& fetch2) {
+        const int key1 = events1.key, key2 = events2.key;
+        int commits = 0;
+        long only1 = 0, only2 = 0;
+        bool stopped = false;
+        stage_stats::mark compareStart = stage_stats::mark::now();
 
-                    std::string val1 = data1[idx1[sig1]];
-                    std::string val2 = data2[idx2[sig2]];
+        for (;;) {
+            while (!events1.ended && (int)events1.rows.size() <= alignLookAhead) events1.ended = !events1.pull(fetch1, data1);
+            while (!events2.ended && (int)events2.rows.size() <= alignLookAhead) events2.ended = !events2.pull(fetch2, data2);
+            if (events1.rows.empty() && events2.rows.empty()) break;
 
-                    if (val1 != val2) {
-                        std::cout << "[Mismatch] Cyc " << cycle << ": " << key 
-                             << " (" << val1 << " != " << val2 << ")" << std::endl;
-                        reportCard[key].mismatches++;
+            // Events to drop from each side before the heads line up
+            size_t skip1 = 0, skip2 = 0;
+            if (events1.rows.empty()) skip2 = 1;
+            else if (events2.rows.empty()) skip1 = 1;
+            else if (events1.rows[0][key1] != events2.rows[0][key2]) {
+                bool synced = false;
+                size_t n1 = events1.rows.size(), n2 = events2.rows.size();
+                for (size_t d = 1; d < n1 + n2 - 1 && !synced; ++d) {
+                    for (size_t i = 0; i <= d && !synced; ++i) {
+                        size_t j = d - i;
+                        if (i < n1 && j < n2 && !(events1.rows[i][key1] != events2.rows[j][key2])) {
+                            skip1 = i;
+                            skip2 = j;
+                            synced = true;
+                        }
                     }
                 }
             }
-            cycle++;
+
+            if ((skip1 > 0 || skip2 > 0) && !events1.rows.empty() && events1.cycles.front() < rangeFirst) {
+                // Resync before the checked range: drop silently
+                for (; skip1 > 0; --skip1) events1.pop();
+                for (; skip2 > 0; --skip2) events2.pop();
+                continue;
+            }
+            if (skip1 > 0 || skip2 > 0) {
+                if (firstDivergence < 0) {
+                    firstDivergence = events1.rows.empty() ? -1 : events1.cycles.front();
+                    firstDivergence2 = events2.rows.empty() ? -1 : events2.cycles.front();
+                    if (firstDivergence < 0) std::swap(firstDivergence, firstDivergence2);
+                }
+                totalMismatches += skip1 + skip2;
+                for (; skip1 > 0; --skip1, ++only1) {
+                    mismatchLog << "[Align] Cyc " << events1.cycles.front() << ": commit " << events1.rows.front()[key1]
+                                << " only in first input\n";
+                    events1.pop();
+                }
+                for (; skip2 > 0; --skip2, ++only2) {
+                    mismatchLog << "[Align] Cyc " << events2.cycles.front() << ": commit " << events2.rows.front()[key2]
+                                << " only in second input\n";
+                    events2.pop();
+                }
+                if (stopAfter > 0 && totalMismatches >= stopAfter) {
+                    stopped = true;
+                    break;
+                }
+                continue;
+            }
+
+            // Heads agree on the key, or no resync point was found within the window: compare them
+            int c1 = events1.cycles.front(), c2 = events2.cycles.front();
+            if (rangeLast >= 0 && c1 > rangeLast) break;
+            if (c1 < rangeFirst) {
+                events1.pop();
+                events2.pop();
+                continue;
+            }
+            long found = checkRow(c1, c2, events1.rows.front(), events2.rows.front());
+            stopped = recordRow(found, c1, c2, events1.rows.front(), events2.rows.front());
+            events1.pop();
+            events2.pop();
+            commits++;
+            if (stageStats != nullptr) stageStats->set(stage_stats::Rows, commits);
+            if (stopped) break;
+        }
+
+        while (stopped && windowOpen() && !events1.rows.empty() && !events2.rows.empty()) {
+            after.push_back(snapshot(events1.cycles.front(), events2.cycles.front(), events1.rows.front(), events2.rows.front()));
+            events1.pop();
+            events2.pop();
         }
+        if (stageStats != nullptr) stageStats->addPhase("compare", compareStart);
 
-        printDetailedReport(cycle, reportCard);
+        finishReport(commits, stopped, only1, only2);
     }
 
-private:
-    void printDetailedReport(int totalCycles, std::map<std::string, Stats>& reportCard) {
+    int trailingRows() const { return (int)after.size() - divergentRows; }
+    bool windowOpen() const { return firstDivergence >= 0 && trailingRows() < window; }
+
+    // Divergence window bookkeeping after a checked row; returns true when the run should stop
+    template <typename ValueA, typename ValueB>
+    bool recordRow(long found, int cycle, int cycle2, const std::vector<ValueA>& data1, const std::vector<ValueB>& data2) {
+        if (found > 0 && firstDivergence < 0) {
+            firstDivergence = cycle;
+            firstDivergence2 = cycle2;
+            divergentRows = 1;
+        }
+        if (window > 0) {
+            if (firstDivergence < 0) {
+                before.push_back(snapshot(cycle, cycle2, data1, data2));
+                if ((int)before.size() > window) before.pop_front();
+            } else if (trailingRows() < window) {
+                after.push_back(snapshot(cycle, cycle2, data1, data2));
+            }
+        }
+        return stopAfter > 0 && totalMismatches >= stopAfter;
+    }
+
+    void finishReport(int total, bool stopped, long only1, long only2) {
+        stage_stats::timer reportTime(stageStats, "report");
+        reportedCycles = total;
+        flushMismatchLog();
+        if (firstDivergence >= 0 && window > 0) printDivergenceWindow();
+        if (stopped) {
+            *out << "[Abort] Stopped after " << totalMismatches << " mismatches" << std::endl;
+        }
+        if (total == 0) *out << "[Empty] No " << (alignKey1.empty() ? "cycles" : "commits") << " compared" << std::endl;
+        if (!alignKey1.empty()) {
+            *out << "[Align] " << total << " commits matched, " << only1 << " only in first input, "
+                      << only2 << " only in second input" << std::endl;
+        }
+        // Map to track stats per signal pair
+        std::map<std::string, Stats> reportCard;
+        for (size_t i = 0; i < plan.size(); ++i) reportCard[pairNames[i]] = stats[i];
+        printDetailedReport(total, reportCard, only1 + only2);
+        reportedUnmatched = only1 + only2;
+        reportedStats = std::move(reportCard);
+        if (stageStats != nullptr) stageStats->finish();
+    }
+
+    template <typename ValueA, typename ValueB>
+    WindowRow snapshot(int cycle, int cycle2, const std::vector<ValueA>& data1, const std::vector<ValueB>& data2) {
+        WindowRow row;
+        row.cycle = cycle;
+        row.cycle2 = cycle2;
+        std::ostringstream text;
+        for (const PlannedCheck& chk : plan) {
+            text.str("");
+            text << data1[chk.col1];
+            row.val1.push_back(text.str());
+            text.str("");
+            text << data2[chk.col2];
+            row.val2.push_back(text.str());
+            row.differs.push_back(data1[chk.col1] != data2[chk.col2]);
+        }
+        return row;
+    }
+
+    template <typename ValueA, typename ValueB>
+    long checkRow(int cycle, int cycle2, const std::vector<ValueA>& data1, const std::vector<ValueB>& data2) {
+        long found = 0;
+        for (const PlannedCheck& chk : plan) {
+            Stats& st = stats[chk.stat];
+            st.checks++;
+
+            const ValueA& val1 = data1[chk.col1];
+            const ValueB& val2 = data2[chk.col2];
+
+            if (val1 != val2) {
+                // Buffered; flushed in blocks instead of once per line
+                mismatchLog << "[Mismatch] ";
+                writeCycle(mismatchLog, cycle, cycle2);
+                mismatchLog << ": " << pairNames[chk.stat] << " (" << val1 << " != " << val2 << ")\n";
+                st.mismatches++;
+                found++;
+            }
+        }
+        totalMismatches += found;
+        if (mismatchLog.tellp() > (1 << 16)) flushMismatchLog();
+        return found;
+    }
+
+    void printDivergenceWindow() {
+        *out << "\n[Divergence] First mismatch at ";
+        writeCycle(*out, firstDivergence, firstDivergence2);
+        *out << " (" << before.size() << " rows before, " << trailingRows() << " after)" << std::endl;
+        for (size_t p = 0; p < pairNames.size(); ++p) {
+            *out << " " << pairNames[p] << "\n";
+            auto printRow = [&](const WindowRow& r) {
+                std::string cyc = std::to_string(r.cycle) + (r.cycle2 >= 0 ? "/" + std::to_string(r.cycle2) : "");
+                writeFormatted("   %s Cyc %-21s %20s | %-20s\n", r.differs[p] ? "*" : " ", cyc.c_str(), r.val1[p].c_str(), r.val2[p].c_str());
+            };
+            for (const auto& r : before) printRow(r);
+            for (const auto& r : after) printRow(r);
+        }
+        *out << std::flush;
+    }
+
+    void printDetailedReport(int totalCycles, std::map<std::string, Stats>& reportCard, long unmatched = 0) {
         long grandTotalChecks = 0;
         long grandTotalMismatches = 0;
         int spaces = 100;
-        std::cout << "\n" << std::string(spaces, '=') << std::endl;
-        std::cout << "                DETAILED SIGNAL COMPARISON REPORT" << std::endl;
-        std::cout << std::string(spaces, '=') << std::endl;
-        printf("%-100s | %-8s | %-8s\n", "Signal Comparison Pair", "Match", "Mismatch");
-        std::cout << std::string(spaces, '-') << std::endl;
+        *out << "\n" << std::string(spaces, '=') << std::endl;
+        *out << "                DETAILED SIGNAL COMPARISON REPORT" << std::endl;
+        *out << std::string(spaces, '=') << std::endl;
+        writeFormatted("%-100s | %-8s | %-8s\n", "Signal Comparison Pair", "Match", "Mismatch");
+        *out << std::string(spaces, '-') << std::endl;
         for (auto const& [pairName, stat] : reportCard) {
             long matches = stat.checks - stat.mismatches;
-            printf("%-100s | %-8ld | %-8ld\n", pairName.c_str(), matches, stat.mismatches);
+            writeFormatted("%-100s | %-8ld | %-8ld\n", pairName.c_str(), matches, stat.mismatches);
             
             grandTotalChecks += stat.checks;
             grandTotalMismatches += stat.mismatches;
@@ -90,11 +636,13 @@ private:
         long grandTotalMatches = grandTotalChecks - grandTotalMismatches;
         double passRate = (grandTotalChecks > 0) ? ((double)grandTotalMatches / grandTotalChecks) * 100.0 : 0.0;
 
-        std::cout << std::string(spaces, '=') << std::endl;
-        std::cout << " SUMMARY STATISTICS" << std::endl;
-        std::cout << " Total Cycles Processed : " << totalCycles << std::endl;
-        std::cout << " Overall Pass Rate      : " << passRate << "%" << std::endl;
-        std::cout << " Final Status           : " << (grandTotalMismatches == 0 ? "PASSED" : "FAILED") << std::endl;
-        std::cout << std::string(spaces, '=') << std::endl;
+        *out << std::string(spaces, '=') << std::endl;
+        *out << " SUMMARY STATISTICS" << std::endl;
+        *out << (alignKey1.empty() ? " Total Cycles Processed : " : " Total Commits Compared : ") << totalCycles << std::endl;
+        if (!alignKey1.empty()) *out << " Unmatched Commits      : " << unmatched << std::endl;
+        else if (unmatched > 0) *out << " Unmatched Rows         : " << unmatched << std::endl;
+        *out << " Overall Pass Rate      : " << passRate << "%" << std::endl;
+        *out << " Final Status           : " << (totalCycles > 0 && grandTotalMismatches == 0 && unmatched == 0 ? "PASSED" : "FAILED") << std::endl;
+        *out << std::string(spaces, '=') << std::endl;
     }
 };
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <charconv>
+#include "mapped_file.hpp"
+#include "vcd_lexer.hpp"
+#include "vcd_value.hpp"
+#include "run_stats.hpp"
+
+// Row source over a Spike commit log (spike --log-commits), one row per committed instruction:
+// spike.pc, spike.rd_addr, spike.rd_data, spike.mem_addr, spike.mem_data. Instructions without an
+// integer register write have rd 0, loads have mem_data 0 (Spike only logs store data). Lines that are
+// not commit records (warnings, trap messages) are skipped, as are the first bootRecords records of
+// the hart, i.e. the bootloader at the Spike reset vector that the RTL does not run.
+class spike_commit_source {
+public:
+    using value_type = vcd_value;
+
+private:
+    std::string path;
+    int core;
+    int bootRecords;
+    mapped_file file;
+    std::string_view text;
+    std::vector<std::string> columns;
+    int records = 0;
+    long commits = 0;
+    uint64_t lines = 0;
+    stage_stats* stageStats = nullptr;
+
+    static uint64_t parseHex(std::string_view s) {
+        if (s.size() > 2 && s[0] == '0' && s[1] == 'x') s.remove_prefix(2);
+        uint64_t v = 0;
+        for (char c : s) {
+            uint64_t d;
+            if (c >= '0' && c <= '9') d = c - '0';
+            else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+            else break;
+            v = (v << 4) | d;
+        }
+        return v;
+    }
+
+    static bool isHex(std::string_view s) {
+        if (!s.empty() && s.front() == '(' && s.back() == ')') s = s.substr(1, s.size() - 2);
+        return s.size() > 2 && s[0] == '0' && s[1] == 'x';
+    }
+
+    void publishStats() {
+        if (stageStats == nullptr) return;
+        stageStats->set(stage_stats::Bytes, file.size() - text.size());
+        stageStats->set(stage_stats::Lines, lines);
+        stageStats->set(stage_stats::Rows, commits);
+    }
+
+public:
+    // hart: only records of this core are returned (-1 = all)
+    spike_commit_source(std::string commitLog, int hart = -1, int skipRecords = 5)
+        : path(commitLog), core(hart), bootRecords(skipRecords) {}
+
+    bool open() {
+        if (!file.open(path)) {
+            std::cerr << "Error: Could not open " << path << std::endl;
+            return false;
+        }
+        text = file.view();
+        if (stageStats != nullptr) stageStats->setTotalBytes(file.size());
+        columns = {"spike.pc", "spike.rd_addr", "spike.rd_data", "spike.mem_addr", "spike.mem_data"};
+        return true;
+    }
+
+    // Publish bytes, lines and commits read to stage; set before open()
+    void setStats(stage_stats* stage) { stageStats = stage; }
+
+    const std::vector<std::string>& columnNames() const { return columns; }
+    long commitsRead() const { return commits; }
+
+    // core N: <priv> 0x<pc> (0x<insn>) [x<rd> 0x<data>] [mem 0x<addr> [0x<data>]] ...
+    bool nextRow(std::vector<vcd_value>& row) {
+        std::string_view fields[16];
+        while (!text.empty()) {
+            size_t nl = text.find('\n');
+            std::string_view line = text.substr(0, nl);
+            text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+            lines++;
+
+            size_t n = 0;
+            std::string_view word;
+            while (n < 16 && vcd_lexer::nextWord(line, word)) fields[n++] = word;
+            if (n < 5 || fields[0] != "core" || fields[1].back() != ':' || !isHex(fields[3]) || !isHex(fields[4])) continue;
+            int recordCore = 0;
+            std::from_chars(fields[1].data(), fields[1].data() + fields[1].size() - 1, recordCore);
+            if (core >= 0 && recordCore != core) continue;
+            if (records++ < bootRecords) continue;
+
+            uint64_t rd = 0, rdData = 0, memAddr = 0, memData = 0;
+            for (size_t i = 5; i < n; ++i) {
+                if (fields[i][0] == 'x' && i + 1 < n) {
+                    std::from_chars(fields[i].data() + 1, fields[i].data() + fields[i].size(), rd);
+                    rdData = parseHex(fields[i + 1]);
+                }
+                if (fields[i] == "mem") {
+                    if (i + 1 < n) memAddr = parseHex(fields[i + 1]);
+                    if (i + 2 < n) memData = parseHex(fields[i + 2]);
+                }
+            }
+
+            if (row.size() != columns.size()) {
+                row.resize(columns.size());
+                for (auto& v : row) v.setWidth(64);
+            }
+            row[0].assignUnsigned(parseHex(fields[3]));
+            row[1].assignUnsigned(rd);
+            row[2].assignUnsigned(rdData);
+            row[3].assignUnsigned(memAddr);
+            row[4].assignUnsigned(memData);
+            commits++;
+            publishStats();
+            return true;
+        }
+        publishStats();
+        if (stageStats != nullptr) stageStats->finish();
+        return false;
+    }
+};
@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <utility>
+#include <cstddef>
+
+// Bounded lock-free single-producer/single-consumer ring. Items are exchanged with std::swap, so
+// when T owns storage (e.g. a row vector) the buffers circulate between producer and consumer
+// instead of being reallocated. A full or empty queue is waited on by spinning briefly, then by
+// sleeping on a condition variable until the other side moves (or a short timeout, to recheck cancel).
+template <typename T>
+class spsc_queue {
+private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};    // next slot to read, owned by the consumer
+    alignas(64) std::atomic<size_t> tail{0};    // next slot to write, owned by the producer
+    alignas(64) std::atomic<bool> closed{false};
+    std::atomic<int> sleepers{0};
+    std::mutex parkLock;
+    std::condition_variable parked;
+
+    static size_t roundUp(size_t n) {
+        size_t p = 1;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    // Waits a little longer each call: spins, a few yields, then sleeps until wake() or the timeout
+    template <typename Ready>
+    void backoff(int& spins, Ready ready) {
+        if (++spins < 64) return;
+        if (spins < 80) {
+            std::this_thread::yield();
+            return;
+        }
+        std::unique_lock<std::mutex> lock(parkLock);
+        sleepers.fetch_add(1);
+        if (!ready()) parked.wait_for(lock, std::chrono::milliseconds(2));
+        sleepers.fetch_sub(1);
+    }
+
+    // After moving head or tail: the fence orders that store before reading sleepers, and a sleeper
+    // checks ready() under parkLock after counting itself, so no wakeup is lost
+    void wake() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> lock(parkLock);
+        parked.notify_all();
+    }
+
+public:
+    explicit spsc_queue(size_t capacity) : slots(roundUp(capacity < 2 ? 2 : capacity)), mask(slots.size() - 1) {}
+
+    // Producer side. Waits while the queue is full; returns false if cancel was raised meanwhile.
+    bool push(T& item, const std::atomic<bool>& cancel) {
+        return push(item, [&cancel] { return cancel.load(std::memory_order_relaxed); });
+    }
+
+    // Same, giving up once stop() returns true while the queue is full
+    template <typename Stop>
+    bool push(T& item, Stop stop) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        int spins = 0;
+        auto ready = [&] { return t - head.load(std::memory_order_acquire) != slots.size(); };
+        while (!ready()) {
+            if (stop()) return false;
+            backoff(spins, ready);
+        }
+        std::swap(slots[t & mask], item);
+        tail.store(t + 1, std::memory_order_release);
+        wake();
+        return true;
+    }
+
+    // Producer side: no more items will be pushed
+    void close() {
+        closed.store(true, std::memory_order_release);
+        wake();
+    }
+
+    // Consumer side. Takes an item if one is queued, without waiting.
+    bool tryPop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        std::swap(item, slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        wake();
+        return true;
+    }
+
+    // Consumer side. Waits for an item; returns false once the queue is closed and drained.
+    bool pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        int spins = 0;
+        auto ready = [&] { return h != tail.load(std::memory_order_acquire) || closed.load(std::memory_order_acquire); };
+        while (h == tail.load(std::memory_order_acquire)) {
+            if (closed.load(std::memory_order_acquire) && h == tail.load(std::memory_order_acquire)) return false;
+            backoff(spins, ready);
+        }
+        std::swap(item, slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        wake();
+        return true;
+    }
+};
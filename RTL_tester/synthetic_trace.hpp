@@ -0,0 +1,215 @@
+#pragma once
+#include <cstdio>
+#include <cstdint>
+#include <charconv>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Size and shape of a generated workload
+struct synthetic_trace_config {
+    long cycles = 1000000;
+    int extraSignals = 64;          // 32-bit filler signals in each dump, not selected by the converters
+    double toggleRate = 0.25;       // chance that a filler or memory signal changes in a cycle
+    double commitRate = 0.5;        // chance that an instruction retires in a cycle
+    uint64_t seed = 1;
+};
+
+// Writes matching inputs of any size for benchmarks: an RTL dump (cpu_top_tb.dut...), a simulator
+// dump (Module...), and the Spike commit_trace.log / instruction_trace.log of the same program.
+// Values are a hash of (seed, signal, cycle), so the two dumps and the logs agree without sharing
+// state and every stage of a comparison runs over the whole workload. Signal names are the defaults
+// of vcd_checker.cpp.
+class synthetic_trace {
+private:
+    synthetic_trace_config cfg;
+
+    // Columns of the compared writeback/memory signals, then the filler signals
+    enum { Pc, RdData, RdAddr, MemData, FirstExtra };
+
+    struct Output {
+        FILE* file = nullptr;
+        std::string buf;
+        bool failed = false;
+
+        bool open(const std::string& path) {
+            file = std::fopen(path.c_str(), "wb");
+            if (file == nullptr) std::cerr << "Error: Could not write " << path << std::endl;
+            buf.reserve(1 << 20);
+            return file != nullptr;
+        }
+        void flushIfFull() {
+            if (buf.size() >= (1 << 20)) flush();
+        }
+        void flush() {
+            if (std::fwrite(buf.data(), 1, buf.size(), file) != buf.size()) failed = true;
+            buf.clear();
+        }
+        bool close() {
+            flush();
+            return std::fclose(file) == 0 && !failed;
+        }
+    };
+
+    static uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    uint64_t hash(int signal, long cycle) const { return mix(cfg.seed ^ mix(((uint64_t)signal << 40) ^ (uint64_t)cycle)); }
+    bool happens(double rate, int signal, long cycle) const { return (hash(signal, cycle) >> 11) * 0x1.0p-53 < rate; }
+
+    static std::string identifier(int n) {
+        std::string id;
+        do {
+            id += char('!' + n % 94);
+            n /= 94;
+        } while (n > 0);
+        return id;
+    }
+
+    static void appendHex(std::string& out, uint32_t v) {
+        char digits[8];
+        for (int i = 7; i >= 0; --i, v >>= 4) digits[i] = "0123456789abcdef"[v & 15];
+        out += "0x";
+        out.append(digits, 8);
+    }
+
+    static void appendBinary(std::string& out, const std::string& id, uint64_t v) {
+        char digits[64];
+        auto end = std::to_chars(digits, digits + sizeof(digits), v, 2).ptr;
+        out += 'b';
+        out.append(digits, end);
+        out += ' ';
+        out += id;
+        out += '\n';
+    }
+
+    // The n-th committed instruction
+    uint32_t commitPc(long n) const { return 0x80000000u + 4 * (uint32_t)n; }
+    uint32_t commitRd(long n) const { return 1 + hash(RdAddr, n) % 31; }
+    uint32_t commitData(long n) const { return (uint32_t)hash(RdData, n); }
+
+    // One dump: the clock in the clockScopes, each group (scope name, then its signals) under innerScopes
+    bool writeVcd(const std::string& path, const std::vector<std::string>& clockScopes, const std::string& clockName,
+                  const std::vector<std::string>& innerScopes, const std::vector<std::vector<std::string>>& groups) const {
+        Output out;
+        if (!out.open(path)) return false;
+        std::string& o = out.buf;
+        o += "$date synthetic $end\n$timescale 1ns $end\n";
+        for (const std::string& s : clockScopes) o += "$scope module " + s + " $end\n";
+        o += "$var wire 1 ! " + clockName + " $end\n";
+        for (const std::string& s : innerScopes) o += "$scope module " + s + " $end\n";
+        int id = 1;
+        std::vector<std::string> ids;
+        for (const auto& group : groups) {
+            o += "$scope module " + group[0] + " $end\n";
+            for (size_t i = 1; i < group.size(); ++i) {
+                ids.push_back(identifier(id++));
+                o += "$var wire 32 " + ids.back() + " " + group[i] + " [31:0] $end\n";
+            }
+            o += "$upscope $end\n";
+        }
+        for (size_t i = 0; i < clockScopes.size() + innerScopes.size(); ++i) o += "$upscope $end\n";
+        o += "$enddefinitions $end\n#0\n$dumpvars\n0!\n";
+        appendBinary(o, ids[Pc], commitPc(0));
+        appendBinary(o, ids[RdData], commitData(0));
+        appendBinary(o, ids[RdAddr], commitRd(0));
+        for (size_t s = MemData; s < ids.size(); ++s) appendBinary(o, ids[s], 0);
+        o += "$end\n";
+
+        // Rising edge at 10c+5; values change at 10c+10, in time for the next edge
+        long commits = 1;
+        for (long c = 0; c < cfg.cycles; ++c) {
+            o += '#';
+            o += std::to_string(10 * c + 5);
+            o += "\n1!\n#";
+            o += std::to_string(10 * c + 10);
+            o += "\n0!\n";
+            if (c + 1 < cfg.cycles && happens(cfg.commitRate, -1, c)) {
+                appendBinary(o, ids[Pc], commitPc(commits));
+                appendBinary(o, ids[RdData], commitData(commits));
+                appendBinary(o, ids[RdAddr], commitRd(commits));
+                commits++;
+            }
+            for (size_t s = MemData; s < ids.size(); ++s) {
+                if (happens(cfg.toggleRate, (int)s, c)) appendBinary(o, ids[s], (uint32_t)hash((int)s + 1000, c));
+            }
+            out.flushIfFull();
+        }
+        return out.close();
+    }
+
+    std::vector<std::string> fillerNames() const {
+        std::vector<std::string> names = {"u_gen"};
+        for (int i = 0; i < cfg.extraSignals; ++i) names.push_back("sig" + std::to_string(i));
+        return names;
+    }
+
+public:
+    explicit synthetic_trace(const synthetic_trace_config& config) : cfg(config) {}
+
+    // Instructions retired over the whole run, i.e. commit records after the boot records. The first one
+    // is already in the writeback stage when the dump starts, so every sampled cycle shows a commit.
+    long commitCount() const {
+        long n = 1;
+        for (long c = 0; c + 1 < cfg.cycles; ++c) n += happens(cfg.commitRate, -1, c);
+        return n;
+    }
+
+    bool writeRtlVcd(const std::string& path) const {
+        return writeVcd(path, {"cpu_top_tb", "dut"}, "clk", {"u_cpu"},
+                        {{"u_writeback", "pc_in", "rd_data_in", "rd_addr_in"}, {"u_memory", "mem_wr_data_in"}, fillerNames()});
+    }
+
+    bool writeSimVcd(const std::string& path) const {
+        return writeVcd(path, {"Module"}, "Clock", {},
+                        {{"u_writeback", "writeback2memory_pc_in", "writeback2memory_rd_data_in", "writeback2memory_rd_addr_in"},
+                         {"u_memory", "memory2exec_mem_wr_data_in"}, fillerNames()});
+    }
+
+    // Both Spike logs, with the 5 bootloader records the tools skip in front
+    bool writeSpikeLogs(const std::string& commitPath, const std::string& tracePath) const {
+        Output commit, trace;
+        if (!commit.open(commitPath) || !trace.open(tracePath)) return false;
+        commit.buf += "warning: tohost and fromhost symbols not in ELF; can't communicate with target\n";
+        trace.buf += commit.buf;
+        for (uint32_t i = 0; i < 5; ++i) {
+            commit.buf += "core   0: 3 ";
+            appendHex(commit.buf, 0x1000 + 4 * i);
+            commit.buf += " (0x00000297) x5  0x00001000\n";
+            trace.buf += "core   0: ";
+            appendHex(trace.buf, 0x1000 + 4 * i);
+            trace.buf += " (0x00000297) auipc   t0, 0x0\n";
+        }
+
+        long commits = commitCount();
+        for (long n = 0; n < commits; ++n) {
+            uint32_t rd = commitRd(n);
+            uint32_t insn = 0x00000013 | (rd << 7);     // addi rd, x0, 0
+            commit.buf += "core   0: 3 ";
+            appendHex(commit.buf, commitPc(n));
+            commit.buf += " (";
+            appendHex(commit.buf, insn);
+            commit.buf += ") x";
+            commit.buf += std::to_string(rd);
+            commit.buf += rd < 10 ? "  " : " ";
+            appendHex(commit.buf, commitData(n));
+            commit.buf += '\n';
+
+            trace.buf += "core   0: ";
+            appendHex(trace.buf, commitPc(n));
+            trace.buf += " (";
+            appendHex(trace.buf, insn);
+            trace.buf += ") li      x";
+            trace.buf += std::to_string(rd);
+            trace.buf += ", 0\n";
+            commit.flushIfFull();
+            trace.flushIfFull();
+        }
+        bool ok = commit.close();
+        return trace.close() && ok;
+    }
+};
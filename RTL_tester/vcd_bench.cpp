@@ -0,0 +1,417 @@
+#include "synthetic_trace.hpp"
+#include "sim_core_vcd_conv.hpp"
+#include "rtl_core_vcd_conv.hpp"
+#include "signal_comparator.hpp"
+#include "pipelined_source.hpp"
+#include "spike_commit_source.hpp"
+#include "rtl_commit_source.hpp"
+#include "shared_source.hpp"
+#include <bitset>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+// Benchmark of every stage on a generated workload of any size. Prints a table and writes the results
+// as JSON (--json) for tracking regressions, e.g.
+//
+//   ./vcd_bench --cycles 2000000 --signals 128 --toggle 0.1 --repeat 3 --merge ../parserv5
+//
+// --merge runs the given parserv5 binary on the generated Spike logs; the Spike merge lives in its
+// own program and is only timed as a whole. Each stage is run --repeat times and the fastest run counts.
+
+std::set<std::string> sim_signals = {
+    "Module.Clock",
+    "Module.u_writeback.writeback2memory_pc_in",
+    "Module.u_writeback.writeback2memory_rd_data_in",
+    "Module.u_writeback.writeback2memory_rd_addr_in",
+    "Module.u_memory.memory2exec_mem_wr_data_in"
+};
+std::set<std::string> rtl_signals = {
+    "dut.clk",
+    "u_writeback.pc_in",
+    "u_writeback.rd_data_in",
+    "u_writeback.rd_addr_in",
+    "u_memory.mem_wr_data_in"
+};
+std::map<std::string, std::string> compare_map = {
+    {"Module.u_writeback.writeback2memory_rd_data_in", "cpu_top_tb.dut.u_cpu.u_writeback.rd_data_in"},
+    {"Module.u_writeback.writeback2memory_pc_in", "cpu_top_tb.dut.u_cpu.u_writeback.pc_in"},
+    {"Module.u_writeback.writeback2memory_rd_addr_in", "cpu_top_tb.dut.u_cpu.u_writeback.rd_addr_in"},
+    {"Module.u_memory.memory2exec_mem_wr_data_in", "cpu_top_tb.dut.u_cpu.u_memory.mem_wr_data_in"}
+};
+rtl_commit_signals commit_signals = {
+    "",
+    "cpu_top_tb.dut.u_cpu.u_writeback.pc_in",
+    "cpu_top_tb.dut.u_cpu.u_writeback.rd_addr_in",
+    "cpu_top_tb.dut.u_cpu.u_writeback.rd_data_in",
+    "", "", "", "", ""
+};
+
+struct bench_result {
+    std::string name;
+    double seconds;
+    uint64_t bytes;     // input read by the stage
+    uint64_t items;     // cycles, or committed instructions for the Spike stages
+};
+
+// Swallows the progress lines of the converters and the comparison reports while a stage is timed
+struct quiet_stdout {
+    std::ostringstream sink;
+    std::streambuf* saved;
+    quiet_stdout() : saved(std::cout.rdbuf(sink.rdbuf())) {}
+    ~quiet_stdout() { std::cout.rdbuf(saved); }
+};
+
+uint64_t file_bytes(const std::string& path) {
+    std::error_code ec;
+    uint64_t n = std::filesystem::file_size(path, ec);
+    return ec ? 0 : n;
+}
+
+// Fastest of repeat runs; stage() returns the number of items it processed, 0 on failure
+bench_result measure(const std::string& name, int repeat, uint64_t bytes, const std::function<uint64_t()>& stage) {
+    bench_result best = {name, 1e300, bytes, 0};
+    for (int r = 0; r < repeat; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t items;
+        {
+            quiet_stdout quiet;
+            items = stage();
+        }
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (s < best.seconds) best = {name, s, bytes, items};
+    }
+    return best;
+}
+
+// Compresses vcd, keeps only the first half of the compressed file and converts that: the conversion has
+// to fail instead of leaving a partial CSV behind as if the dump had ended there
+bool truncated_input_fails(const std::string& vcd, const std::string& dir, compressed_file::Format format) {
+    mapped_file in(vcd);
+    if (!in.is_open()) return false;
+    std::string path = dir + (format == compressed_file::Gzip ? "truncated.vcd.gz" : "truncated.vcd.zst");
+#ifndef VCD_NO_ZLIB
+    if (format == compressed_file::Gzip) {
+        gzFile gz = gzopen(path.c_str(), "wb1");
+        if (gz == nullptr) return false;
+        for (size_t pos = 0; pos < in.size(); pos += 1 << 20) {
+            gzwrite(gz, in.data() + pos, (unsigned)std::min<size_t>(1 << 20, in.size() - pos));
+        }
+        gzclose(gz);
+    }
+#endif
+#ifdef VCD_WITH_ZSTD
+    if (format == compressed_file::Zstd) {
+        std::string out(ZSTD_compressBound(in.size()), '\0');
+        size_t n = ZSTD_compress(&out[0], out.size(), in.data(), in.size(), 1);
+        if (ZSTD_isError(n)) return false;
+        std::ofstream(path, std::ios::binary).write(out.data(), n);
+    }
+#endif
+    uint64_t bytes = file_bytes(path);
+    if (bytes == 0) return false;
+    std::filesystem::resize_file(path, bytes / 2);
+
+    // The decode error messages are expected here
+    std::ostringstream errors;
+    std::streambuf* savedErrors = std::cerr.rdbuf(errors.rdbuf());
+    bool failed;
+    {
+        quiet_stdout quiet;
+        rtl_core_vcd_conv conv(path, dir + "truncated.csv", rtl_signals, 1);
+        failed = !conv.run() && conv.hasFailed();
+    }
+    std::cerr.rdbuf(savedErrors);
+    std::filesystem::remove(path);
+    std::filesystem::remove(dir + "truncated.csv");
+    return failed;
+}
+
+bool same_file(const std::string& a, const std::string& b) {
+    mapped_file fa(a), fb(b);
+    return fa.is_open() && fb.is_open() && fa.view() == fb.view();
+}
+
+// Converts vcd sequentially and then in parallel with small chunks, so many chunk boundaries fall inside
+// the dump, and checks that both CSVs are byte-for-byte the same. Runs on any number of cores.
+template <typename Converter>
+bool parallel_matches_sequential(const std::string& vcd, const std::set<std::string>& signals, const std::string& dir) {
+    std::string seqCsv = dir + "sequential.csv", parCsv = dir + "parallel.csv";
+    bool same;
+    {
+        quiet_stdout quiet;
+        Converter seq(vcd, seqCsv, signals, 1);
+        seq.setParseThreads(1);
+        same = seq.run();
+        for (size_t chunk : {size_t(4096), size_t(65537)}) {
+            Converter par(vcd, parCsv, signals, 1);
+            par.setParseThreads(4, chunk);
+            same = same && par.run() && same_file(seqCsv, parCsv);
+        }
+    }
+    std::filesystem::remove(seqCsv);
+    std::filesystem::remove(parCsv);
+    return same;
+}
+
+// Two domains, wb and mem, sampled on clk while their valid is 1; the mem valid is memValid in every cycle
+bool write_domain_vcd(const std::string& path, int cycles, bool memValid) {
+    std::ofstream vcd(path);
+    vcd << "$timescale 1ns $end\n$scope module top $end\n$var wire 1 ! clk $end\n$var wire 1 \" wb_valid $end\n"
+           "$var wire 32 # wb_pc $end\n$var wire 1 $ mem_valid $end\n$var wire 32 % mem_addr $end\n"
+           "$upscope $end\n$enddefinitions $end\n#0\n0!\n1\"\n" << (memValid ? "1$" : "0$") << "\n";
+    for (int c = 0; c < cycles; ++c) {
+        vcd << "#" << 10 * c << "\n0!\nb" << std::bitset<32>(4 * c) << " #\nb" << std::bitset<32>(c) << " %\n#"
+            << 10 * c + 5 << "\n1!\n";
+    }
+    return bool(vcd);
+}
+
+// Per-domain comparison where the RTL never asserts mem_valid and the simulation always does: the mem
+// comparison waits for RTL rows while both dumps keep producing wb rows, which used to hang once a
+// domain queue filled up. Returns the wb cycles when wb passes and mem fails, 0 otherwise.
+uint64_t skewed_domains(const std::string& dir, int cycles) {
+    std::string simVcd = dir + "skew_sim.vcd", rtlVcd = dir + "skew_rtl.vcd";
+    if (!write_domain_vcd(simVcd, cycles, true) || !write_domain_vcd(rtlVcd, cycles, false)) return 0;
+    vcd_sample_domain wb{"wb", "top.clk", vcd_sample_domain::Rising, "top.wb_valid", {"top.wb_pc"}};
+    vcd_sample_domain mem{"mem", "top.clk", vcd_sample_domain::Rising, "top.mem_valid", {"top.mem_addr"}};
+    rtl_core_vcd_conv sim(simVcd, "", {}, 1), rtl(rtlVcd, "", {}, 1);
+    for (rtl_core_vcd_conv* conv : {&sim, &rtl}) {
+        conv->addDomain(wb);
+        conv->addDomain(mem);
+    }
+    if (!sim.open(false) || !rtl.open(false)) return 0;
+
+    std::map<std::string, std::string> maps[2] = {{{"top.wb_pc", "top.wb_pc"}}, {{"top.mem_addr", "top.mem_addr"}}};
+    signal_comparator comparators[2];
+    std::ostringstream reports[2];
+    {
+        shared_source<rtl_core_vcd_conv> simRows(sim, 0), rtlRows(rtl, 0);
+        std::vector<std::thread> workers;
+        for (size_t d = 0; d < 2; ++d) {
+            workers.emplace_back([&, d] {
+                comparators[d].setOutput(reports[d]);
+                comparators[d].compareStreams(simRows.at(d), rtlRows.at(d), maps[d]);
+                simRows.at(d).detach();
+                rtlRows.at(d).detach();
+            });
+        }
+        for (auto& w : workers) w.join();
+    }
+    std::filesystem::remove(simVcd);
+    std::filesystem::remove(rtlVcd);
+    bool wbPassed = comparators[0].complete() && comparators[0].cyclesCompared() == cycles && comparators[0].mismatchCount() == 0;
+    bool memFailed = !comparators[1].complete();
+    return wbPassed && memFailed ? cycles : 0;
+}
+
+// For stages that could hang: runs stage on its own thread and ends the process with an error if it
+// is still running after seconds
+uint64_t with_watchdog(const std::string& name, double seconds, const std::function<uint64_t()>& stage) {
+    auto done = std::make_shared<std::promise<uint64_t>>();
+    std::future<uint64_t> result = done->get_future();
+    std::thread([done, stage] { done->set_value(stage()); }).detach();
+    if (result.wait_for(std::chrono::duration<double>(seconds)) != std::future_status::ready) {
+        std::cerr << "Error: stage " << name << " did not finish within " << seconds << " s" << std::endl;
+        std::_Exit(1);
+    }
+    return result.get();
+}
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    synthetic_trace_config cfg;
+    int repeat = 3;
+    int threads = std::thread::hardware_concurrency();
+    std::string dir = "bench_data/";
+    std::string jsonPath = "bench_results.json";
+    std::string mergeBinary;
+    bool reuse = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string value = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--reuse") { reuse = true; continue; }
+        if (value.empty()) {
+            std::cerr << "Usage: vcd_bench [--cycles N] [--signals N] [--toggle P] [--commit-rate P] [--seed N] [--repeat N]"
+                         " [--threads N] [--dir D] [--json F] [--merge PARSERV5] [--reuse]" << std::endl;
+            return 1;
+        }
+        ++i;
+        if (arg == "--cycles") cfg.cycles = std::stol(value);
+        else if (arg == "--signals") cfg.extraSignals = std::stoi(value);
+        else if (arg == "--toggle") cfg.toggleRate = std::stod(value);
+        else if (arg == "--commit-rate") cfg.commitRate = std::stod(value);
+        else if (arg == "--seed") cfg.seed = std::stoull(value);
+        else if (arg == "--repeat") repeat = std::max(1, std::stoi(value));
+        else if (arg == "--threads") threads = std::max(1, std::stoi(value));
+        else if (arg == "--dir") dir = value.back() == '/' ? value : value + "/";
+        else if (arg == "--json") jsonPath = value;
+        else if (arg == "--merge") mergeBinary = value;
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::string rtlVcd = dir + "cpu_top_tb.vcd", simVcd = dir + "dump.vcd";
+    std::string rtlCsv = dir + "rtl_core.csv", simCsv = dir + "simulation_core.csv";
+    std::string commitLog = dir + "commit_trace.log", traceLog = dir + "instruction_trace.log";
+    std::filesystem::create_directories(dir);
+
+    // --reuse skips generation when a previous run left the inputs; the config must be the same
+    synthetic_trace generator(cfg);
+    uint64_t commits = generator.commitCount();
+    std::vector<bench_result> results;
+    if (!reuse || file_bytes(rtlVcd) == 0 || file_bytes(simVcd) == 0 || file_bytes(commitLog) == 0) {
+        std::cout << "Generating " << cfg.cycles << " cycles into " << dir << std::endl;
+        bench_result gen = measure("generate", 1, 0, [&]() -> uint64_t {
+            if (!generator.writeRtlVcd(rtlVcd) || !generator.writeSimVcd(simVcd) || !generator.writeSpikeLogs(commitLog, traceLog)) return 0;
+            return cfg.cycles;
+        });
+        if (gen.items == 0) return 1;
+        gen.bytes = file_bytes(rtlVcd) + file_bytes(simVcd) + file_bytes(commitLog) + file_bytes(traceLog);
+        results.push_back(gen);
+    }
+
+    uint64_t rtlBytes = file_bytes(rtlVcd), simBytes = file_bytes(simVcd);
+    uint64_t logBytes = file_bytes(commitLog) + file_bytes(traceLog);
+
+    if (!mergeBinary.empty()) {
+        std::string command = "\"" + mergeBinary + "\" \"" + dir + "\" \"" + dir + "\" > /dev/null";
+        results.push_back(measure("spike_merge", repeat, logBytes, [&]() -> uint64_t {
+            return std::system(command.c_str()) == 0 ? commits : 0;
+        }));
+    }
+
+    results.push_back(measure("spike_commit_source", repeat, file_bytes(commitLog), [&]() -> uint64_t {
+        spike_commit_source spike(commitLog);
+        if (!spike.open()) return 0;
+        std::vector<vcd_value> row;
+        while (spike.nextRow(row)) {}
+        return spike.commitsRead();
+    }));
+
+    results.push_back(measure("sim_convert", repeat, simBytes, [&]() -> uint64_t {
+        sim_core_vcd_conv conv(simVcd, simCsv, sim_signals, 1);
+        conv.setParseThreads(1);
+        conv.run();
+        return conv.cyclesSampled();
+    }));
+
+    results.push_back(measure("rtl_convert", repeat, rtlBytes, [&]() -> uint64_t {
+        rtl_core_vcd_conv conv(rtlVcd, rtlCsv, rtl_signals, 1);
+        conv.setParseThreads(1);
+        conv.run();
+        return conv.cyclesSampled();
+    }));
+
+    if (threads > 1) {
+        results.push_back(measure("rtl_convert_parallel", repeat, rtlBytes, [&]() -> uint64_t {
+            rtl_core_vcd_conv conv(rtlVcd, rtlCsv, rtl_signals, 1);
+            conv.setParseThreads(threads);
+            conv.run();
+            return conv.cyclesSampled();
+        }));
+    }
+
+    results.push_back(measure("compare_csv", repeat, file_bytes(simCsv) + file_bytes(rtlCsv), [&]() -> uint64_t {
+        signal_comparator comparator;
+        comparator.compare(simCsv, rtlCsv, compare_map);
+        return comparator.mismatchCount() == 0 ? comparator.cyclesCompared() : 0;
+    }));
+
+    results.push_back(measure("compare_stream", repeat, simBytes + rtlBytes, [&]() -> uint64_t {
+        sim_core_vcd_conv sim(simVcd, "", sim_signals, 1);
+        rtl_core_vcd_conv rtl(rtlVcd, "", rtl_signals, 1);
+        if (!sim.open(false) || !rtl.open(false)) return 0;
+        pipelined_source<sim_core_vcd_conv> simRows(sim);
+        pipelined_source<rtl_core_vcd_conv> rtlRows(rtl);
+        signal_comparator comparator;
+        comparator.compareStreams(simRows, rtlRows, compare_map);
+        return comparator.mismatchCount() == 0 ? comparator.cyclesCompared() : 0;
+    }));
+
+    results.push_back(measure("spike_check", repeat, file_bytes(commitLog) + rtlBytes, [&]() -> uint64_t {
+        spike_commit_source spike(commitLog);
+        rtl_core_vcd_conv rtl(rtlVcd, "", commit_signals.names(), 1);
+        rtl.setClock("dut.clk");
+        if (!spike.open() || !rtl.open(false)) return 0;
+        pipelined_source<rtl_core_vcd_conv> rtlRows(rtl);
+        rtl_commit_source<pipelined_source<rtl_core_vcd_conv>> rtlCommits(rtlRows, commit_signals);
+        if (!rtlCommits.isValid()) return 0;
+        signal_comparator comparator;
+        comparator.compareStreams(spike, rtlCommits, {{"spike.pc", commit_signals.wbPc},
+                                                      {"spike.rd_addr", commit_signals.wbRdAddr},
+                                                      {"spike.rd_data", commit_signals.wbRdData}});
+        return comparator.mismatchCount() == 0 ? comparator.cyclesCompared() : 0;
+    }));
+
+    results.push_back(measure("domain_skew", repeat, 0, [&]() -> uint64_t {
+        return with_watchdog("domain_skew", 60, [&] { return skewed_domains(dir, 5000); });
+    }));
+
+    std::cout << std::left << std::setw(22) << "stage" << std::right << std::setw(12) << "seconds" << std::setw(12) << "MB/s"
+              << std::setw(16) << "cycles/s" << std::endl;
+    std::ofstream json(jsonPath);
+    json << "{\n  \"config\": {\"cycles\": " << cfg.cycles << ", \"signals\": " << cfg.extraSignals << ", \"toggle\": "
+         << cfg.toggleRate << ", \"commit_rate\": " << cfg.commitRate << ", \"seed\": " << cfg.seed << ", \"repeat\": "
+         << repeat << ", \"threads\": " << threads << ", \"commits\": " << commits << "},\n  \"stages\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const bench_result& r = results[i];
+        double mbps = r.bytes / 1e6 / r.seconds, rate = r.items / r.seconds;
+        std::cout << std::left << std::setw(22) << r.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << r.seconds << std::setprecision(1) << std::setw(12) << mbps
+                  << std::setprecision(0) << std::setw(16) << rate << std::endl;
+        json << std::fixed << (i ? "," : "") << "\n    {\"name\": \"" << json_escape(r.name) << "\", \"seconds\": " << std::setprecision(6)
+             << r.seconds << ", \"bytes\": " << r.bytes << ", \"items\": " << r.items << ", \"mb_per_s\": "
+             << std::setprecision(3) << mbps << ", \"cycles_per_s\": " << std::setprecision(1) << rate << "}";
+    }
+    json << "\n  ]\n}\n";
+    std::cout << "Results written to " << jsonPath << std::endl;
+
+    // A stage that did no work, or a comparison of the generated inputs that mismatched, means a broken
+    // build or input, which CI should see
+    for (const bench_result& r : results) {
+        if (r.items == 0) {
+            std::cerr << "Error: stage " << r.name << " failed or found mismatches" << std::endl;
+            return 1;
+        }
+    }
+    std::vector<compressed_file::Format> formats;
+#ifndef VCD_NO_ZLIB
+    formats.push_back(compressed_file::Gzip);
+#endif
+#ifdef VCD_WITH_ZSTD
+    formats.push_back(compressed_file::Zstd);
+#endif
+    if (!parallel_matches_sequential<rtl_core_vcd_conv>(rtlVcd, rtl_signals, dir) ||
+        !parallel_matches_sequential<sim_core_vcd_conv>(simVcd, sim_signals, dir)) {
+        std::cerr << "Error: the parallel parse wrote a different CSV than the sequential one" << std::endl;
+        return 1;
+    }
+    for (compressed_file::Format format : formats) {
+        if (!truncated_input_fails(rtlVcd, dir, format)) {
+            std::cerr << "Error: a truncated " << (format == compressed_file::Gzip ? ".vcd.gz" : ".vcd.zst")
+                      << " dump was converted without an error" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
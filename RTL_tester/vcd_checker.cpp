@@ -1,8 +1,20 @@
 #include "sim_core_vcd_conv.hpp"
 #include "rtl_core_vcd_conv.hpp"
 #include "signal_comparator.hpp"
+#include "pipelined_source.hpp"
+#include "shared_source.hpp"
+#include "spike_commit_source.hpp"
+#include "rtl_commit_source.hpp"
+#include "batch_runner.hpp"
+#include "run_stats.hpp"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
-// 1. Define the signals you want to extract
+#include <memory>
+#include <sstream>
+#include <thread>
+// 1. Define the signals you want to extract. Each entry selects the signals whose path ends with it,
+// and may be a glob ("u_writeback.*", "u_cpu*.rd_*") or a regex ("re:u_cpu[0-9]+\\.rd_.*")
 std::set<std::string> sim_signals = {
     "Module.Clock",
     "Module.u_writeback.writeback2memory_pc_in",
@@ -19,17 +31,279 @@ std::set<std::string> rtl_signals = {
     // Fetch Stage (u_fetch)
 };
 bool csv_generated = true;
-int main() {
-    
+// Compare the two VCDs in lockstep instead of going through the CSV files on disk
+bool stream_compare = false;
+// In streaming mode, still write simulation_core.csv / rtl_core.csv as a side product
+bool stream_write_csv = false;
+// In streaming mode, parse each VCD on its own thread and compare rows as they arrive
+bool stream_pipelined = true;
+// Threads used to parse each VCD when generating the CSV files (1 = sequential)
+int parse_threads = std::thread::hardware_concurrency();
+// Stop comparing after this many mismatches (0 = compare the whole dump) and show this many
+// cycles of every compared signal around the first divergence (0 = no window)
+long stop_after_mismatches = 0;
+int divergence_window = 0;
+// Compare committed instructions (rows where the writeback PC changes) instead of raw cycles, so
+// stalls, bubbles and extra reset cycles do not shift the rest of the comparison
+bool align_on_commit = false;
+int align_look_ahead = 16;
+// Also write simulation_core.vtr / rtl_core.vtr binary traces when generating the CSV files, and
+// compare those instead of the CSVs
+bool use_binary_trace = false;
+// Streaming comparison: save both parse positions and the comparison counters to checkpoint_file
+// every checkpoint_every cycles (empty = no checkpoints). With resume_checkpoint the run continues
+// from the saved checkpoint instead of re-parsing both dumps; the inputs are then read without the
+// pipeline threads, so the saved positions match the compared cycle.
+std::string checkpoint_file = "";
+int checkpoint_every = 1000000;
+bool resume_checkpoint = false;
+// Only check cycles compare_first_cycle..compare_last_cycle (-1 = to the end), and in streaming mode
+// only sample dump times [dump_time_begin, dump_time_end) of both VCDs
+int compare_first_cycle = 0;
+int compare_last_cycle = -1;
+uint64_t dump_time_begin = 0;
+uint64_t dump_time_end = UINT64_MAX;
+// Multi-hart configurations: one entry per hart, each compared against its RTL core on its own thread.
+// Both VCDs may be the same multi-core dump with a different signal set per hart: each distinct dump
+// is parsed once, for the union of the signals of the harts that read it (so on one clock), and its
+// rows go to all of them. When the list is not empty it replaces the single comparison below.
+struct hart_check {
+    std::string simVcd, rtlVcd;
+    std::set<std::string> simSignals, rtlSignals;
+    std::map<std::string, std::string> compareMap;
+    std::string alignKey1, alignKey2;   // writeback PC of each side, used with align_on_commit
+};
+std::vector<hart_check> hart_checks = {};
+// Per clock domain checks: each side samples its own signals on the chosen edges of its own clock,
+// optionally only while an enable is 1 (e.g. a memory stage valid). Each dump is parsed once for all
+// domains, and every domain is compared on its own thread with its own compareMap, whose names must be
+// signals of that domain. When the list is not empty it replaces the single comparison; with
+// stream_write_csv the rows also go to simulation_core_<name>.csv / rtl_core_<name>.csv.
+struct domain_check {
+    vcd_sample_domain sim, rtl;
+    std::map<std::string, std::string> compareMap;     // { sim signal, RTL signal }
+};
+std::vector<domain_check> domain_checks = {};
+// Check the RTL dump directly against the Spike commit log, one committed instruction at a time,
+// without going through spike_outv2.csv or rtl_core.csv. Replaces the comparisons below when set.
+bool spike_check = false;
+std::string spike_commit_log = "commit_trace.log";
+int spike_check_hart = -1;                          // core of the commit log to check (-1 = all)
+rtl_commit_signals spike_check_signals = {
+    "",                                             // commit on every writeback PC change
+    "cpu_top_tb.dut.u_cpu.u_writeback.pc_in",
+    "cpu_top_tb.dut.u_cpu.u_writeback.rd_addr_in",
+    "cpu_top_tb.dut.u_cpu.u_writeback.rd_data_in",
+    "", "", "", "", ""                              // memory stage, e.g. u_memory valid/pc/addr/wr_data/we
+};
+// Batch mode: run every test of a manifest (format in batch_runner.hpp) on a work-stealing pool and print
+// one combined summary, instead of everything below. The manifest can also be given as the first command
+// line argument. batch_threads 0 = one per core; batch_memory_mb 0 = 80% of the available memory.
+std::string batch_manifest = "";
+int batch_threads = 0;
+long batch_memory_mb = 0;
+std::string batch_report_dir = "batch_reports";
+// Every progress_seconds (0 = never) print how far each running stage is on stderr: bytes of its input,
+// value changes and rows, with rates. At the end the counters, the time of each phase and the peak
+// memory go to stats_file (empty = not written).
+double progress_seconds = 10;
+std::string stats_file = "vcd_checker_stats.json";
+run_stats checker_stats;
+
+// The run_*_check() functions return false when an input could not be opened or read to its end, or a
+// comparison is not complete(): nothing compared, or one input of a lockstep comparison ended first
+bool run_spike_check() {
+    spike_commit_source spike(spike_commit_log, spike_check_hart);
+    rtl_core_vcd_conv rtlParser("cpu_top_tb4.vcd", "rtl_core.csv", spike_check_signals.names(), 1);
+    rtlParser.setClock("dut.clk");
+    spike.setStats(&checker_stats.add("spike"));
+    rtlParser.setStats(&checker_stats.add("rtl"));
+    if (!spike.open() || !rtlParser.open(false)) return false;
+    if (rtlParser.clockName().empty()) {
+        std::cerr << "Error: clock dut.clk not found in cpu_top_tb4.vcd" << std::endl;
+        return false;
+    }
+
+    std::map<std::string, std::string> checkMap = {
+        {"spike.pc", spike_check_signals.wbPc},
+        {"spike.rd_addr", spike_check_signals.wbRdAddr},
+        {"spike.rd_data", spike_check_signals.wbRdData}
+    };
+    if (!spike_check_signals.memValid.empty()) {
+        checkMap["spike.mem_addr"] = spike_check_signals.memAddr;
+        checkMap["spike.mem_data"] = spike_check_signals.memData;
+    }
+
+    signal_comparator comparator;
+    comparator.setStats(&checker_stats.add("compare"));
+    comparator.setEarlyAbort(stop_after_mismatches, divergence_window);
+    if (align_on_commit) comparator.setAlignment("spike.pc", spike_check_signals.wbPc, align_look_ahead);
+    if (stream_pipelined) {
+        pipelined_source<rtl_core_vcd_conv> rtlRows(rtlParser);
+        rtl_commit_source<pipelined_source<rtl_core_vcd_conv>> rtlCommits(rtlRows, spike_check_signals);
+        if (rtlCommits.isValid()) comparator.compareStreams(spike, rtlCommits, checkMap);
+    } else {
+        rtl_commit_source<rtl_core_vcd_conv> rtlCommits(rtlParser, spike_check_signals);
+        if (rtlCommits.isValid()) comparator.compareStreams(spike, rtlCommits, checkMap);
+    }
+    return !rtlParser.hasFailed() && comparator.complete();
+}
+
+// One parse of a dump for all the harts that read it; output i of rows feeds harts[i]
+template <typename Converter>
+struct hart_dump {
+    std::set<std::string> signals;
+    std::vector<size_t> harts;
+    std::unique_ptr<Converter> parser;
+    std::unique_ptr<shared_source<Converter>> rows;
+};
+
+template <typename Converter>
+bool open_hart_dumps(std::map<std::string, hart_dump<Converter>>& dumps, const std::string& side) {
+    for (auto& [path, dump] : dumps) {
+        dump.parser = std::make_unique<Converter>(path, "", dump.signals, 1);
+        dump.parser->setStats(&checker_stats.add(side + ":" + path));
+        dump.parser->setTimeRange(dump_time_begin, dump_time_end);
+        if (!dump.parser->open(false)) return false;
+        dump.rows = std::make_unique<shared_source<Converter>>(*dump.parser, dump.harts.size());
+    }
+    return true;
+}
+
+template <typename Converter>
+typename shared_source<Converter>::output& hart_rows(std::map<std::string, hart_dump<Converter>>& dumps,
+                                                     const std::string& path, size_t hart) {
+    hart_dump<Converter>& dump = dumps[path];
+    size_t i = 0;
+    while (dump.harts[i] != hart) ++i;
+    return dump.rows->at(i);
+}
+
+bool run_hart_checks() {
+    std::map<std::string, hart_dump<sim_core_vcd_conv>> simDumps;
+    std::map<std::string, hart_dump<rtl_core_vcd_conv>> rtlDumps;
+    for (size_t h = 0; h < hart_checks.size(); ++h) {
+        const hart_check& hc = hart_checks[h];
+        simDumps[hc.simVcd].signals.insert(hc.simSignals.begin(), hc.simSignals.end());
+        simDumps[hc.simVcd].harts.push_back(h);
+        rtlDumps[hc.rtlVcd].signals.insert(hc.rtlSignals.begin(), hc.rtlSignals.end());
+        rtlDumps[hc.rtlVcd].harts.push_back(h);
+    }
+    if (!open_hart_dumps(simDumps, "sim") || !open_hart_dumps(rtlDumps, "rtl")) return false;
+
+    std::vector<std::ostringstream> reports(hart_checks.size());
+    std::vector<std::thread> workers;
+    std::atomic<bool> complete{true};
+    for (size_t h = 0; h < hart_checks.size(); ++h) {
+        workers.emplace_back([h, &reports, &simDumps, &rtlDumps, &complete] {
+            const hart_check& hc = hart_checks[h];
+            auto& simRows = hart_rows(simDumps, hc.simVcd, h);
+            auto& rtlRows = hart_rows(rtlDumps, hc.rtlVcd, h);
+            signal_comparator comparator;
+            comparator.setStats(&checker_stats.add("hart" + std::to_string(h) + ".compare"));
+            comparator.setOutput(reports[h]);
+            comparator.setEarlyAbort(stop_after_mismatches, divergence_window);
+            comparator.setCycleRange(compare_first_cycle, compare_last_cycle);
+            if (align_on_commit) comparator.setAlignment(hc.alignKey1, hc.alignKey2, align_look_ahead);
+            comparator.compareStreams(simRows, rtlRows, hc.compareMap);
+            if (!comparator.complete()) complete = false;
+            simRows.detach();
+            rtlRows.detach();
+        });
+    }
+    for (auto& w : workers) w.join();
+    for (size_t h = 0; h < reports.size(); ++h) {
+        std::cout << "\n--- Hart " << h << " ---\n" << reports[h].str();
+    }
+    for (auto& [path, dump] : simDumps) complete = complete && !dump.parser->hasFailed();
+    for (auto& [path, dump] : rtlDumps) complete = complete && !dump.parser->hasFailed();
+    return complete;
+}
+
+// Names of map that are not columns of a domain, for the error of that domain
+std::string missing_columns(const std::map<std::string, std::string>& map, const std::vector<std::string>& simColumns,
+                            const std::vector<std::string>& rtlColumns) {
+    std::string missing;
+    for (const auto& [sim, rtl] : map) {
+        if (std::find(simColumns.begin(), simColumns.end(), sim) == simColumns.end()) missing += " " + sim;
+        if (std::find(rtlColumns.begin(), rtlColumns.end(), rtl) == rtlColumns.end()) missing += " " + rtl;
+    }
+    return missing;
+}
+
+bool run_domain_checks() {
+    sim_core_vcd_conv simParser("dump_2.vcd", "simulation_core.csv", {}, 1);
+    rtl_core_vcd_conv rtlParser("cpu_top_tb4.vcd", "rtl_core.csv", {}, 1);
+    for (const domain_check& dc : domain_checks) {
+        simParser.addDomain(dc.sim);
+        rtlParser.addDomain(dc.rtl);
+    }
+    simParser.setTimeRange(dump_time_begin, dump_time_end);
+    rtlParser.setTimeRange(dump_time_begin, dump_time_end);
+    simParser.setStats(&checker_stats.add("sim"));
+    rtlParser.setStats(&checker_stats.add("rtl"));
+    if (!simParser.open(stream_write_csv) || !rtlParser.open(stream_write_csv)) return false;
+
+    std::vector<std::ostringstream> reports(domain_checks.size());
+    std::vector<std::thread> workers;
+    std::atomic<bool> complete{true};
+    {
+        shared_source<sim_core_vcd_conv> simRows(simParser, 0);
+        shared_source<rtl_core_vcd_conv> rtlRows(rtlParser, 0);
+        for (size_t d = 0; d < domain_checks.size(); ++d) {
+            workers.emplace_back([d, &reports, &simRows, &rtlRows, &complete] {
+                const domain_check& dc = domain_checks[d];
+                auto& sim = simRows.at(d);
+                auto& rtl = rtlRows.at(d);
+                std::string missing = missing_columns(dc.compareMap, sim.columnNames(), rtl.columnNames());
+                if (!missing.empty()) {
+                    reports[d] << "Error: not sampled in this domain:" << missing << std::endl;
+                    complete = false;
+                } else {
+                    signal_comparator comparator;
+                    comparator.setStats(&checker_stats.add(dc.sim.name + ".compare"));
+                    comparator.setOutput(reports[d]);
+                    comparator.setEarlyAbort(stop_after_mismatches, divergence_window);
+                    comparator.setCycleRange(compare_first_cycle, compare_last_cycle);
+                    comparator.compareStreams(sim, rtl, dc.compareMap);
+                    if (!comparator.complete()) complete = false;
+                }
+                sim.detach();
+                rtl.detach();
+            });
+        }
+        for (auto& w : workers) w.join();
+    }
+    for (size_t d = 0; d < reports.size(); ++d) {
+        std::cout << "\n--- Domain " << domain_checks[d].sim.name << " ---\n" << reports[d].str();
+    }
+    return complete && !simParser.hasFailed() && !rtlParser.hasFailed();
+}
+int run_checks(int argc, char** argv) {
+    if (argc > 1) batch_manifest = argv[1];
+    if (!batch_manifest.empty()) {
+        std::vector<batch_test> tests;
+        if (!batch_manifest::load(batch_manifest, tests)) return 1;
+        batch_runner runner(tests, batch_threads, (uint64_t)batch_memory_mb << 20, batch_report_dir);
+        return runner.run() ? 0 : 1;
+    }
+
     // 2. Initialize the Setup: (InputVCD, OutputCSV, SignalSet, GroupSize)
-    if (csv_generated == false) {
+    if (csv_generated == false && stream_compare == false) {
         std::cout << "--- Generating CSV Files from VCDs ---" << std::endl;
         sim_core_vcd_conv mySimParser("dump_2.vcd", "simulation_core.csv", sim_signals, 1);
         rtl_core_vcd_conv myRtlParser("cpu_top_tb4.vcd", "rtl_core.csv", rtl_signals, 1);
+        mySimParser.setParseThreads(parse_threads);
+        myRtlParser.setParseThreads(parse_threads);
+        mySimParser.setStats(&checker_stats.add("sim"));
+        myRtlParser.setStats(&checker_stats.add("rtl"));
+        if (use_binary_trace) {
+            mySimParser.setTraceOutput("simulation_core.vtr");
+            myRtlParser.setTraceOutput("rtl_core.vtr");
+        }
 
         // 3. Run the parsers
-        mySimParser.run();
-        myRtlParser.run();
+        if (!mySimParser.run() || !myRtlParser.run()) return 1;
         csv_generated = true;
     }
     // 2. Define which signals should match
@@ -43,7 +317,73 @@ int main() {
 
     // 3. Run Comparison
     signal_comparator myComparator;
+    myComparator.setEarlyAbort(stop_after_mismatches, divergence_window);
+    myComparator.setCycleRange(compare_first_cycle, compare_last_cycle);
+    if (align_on_commit) {
+        myComparator.setAlignment("Module.u_writeback.writeback2memory_pc_in", "cpu_top_tb.dut.u_cpu.u_writeback.pc_in", align_look_ahead);
+    }
+    if (spike_check) {
+        std::cout << "\n--- Starting Spike Commit Check ---" << std::endl;
+        return run_spike_check() ? 0 : 1;
+    }
+    if (!hart_checks.empty()) {
+        std::cout << "\n--- Starting Per-Hart Signal Comparison ---" << std::endl;
+        return run_hart_checks() ? 0 : 1;
+    }
+    if (!domain_checks.empty()) {
+        std::cout << "\n--- Starting Per-Domain Signal Comparison ---" << std::endl;
+        return run_domain_checks() ? 0 : 1;
+    }
+    myComparator.setStats(&checker_stats.add("compare"));
+    if (stream_compare) {
+        sim_core_vcd_conv mySimParser("dump_2.vcd", "simulation_core.csv", sim_signals, 1);
+        rtl_core_vcd_conv myRtlParser("cpu_top_tb4.vcd", "rtl_core.csv", rtl_signals, 1);
+        mySimParser.setStats(&checker_stats.add("sim"));
+        myRtlParser.setStats(&checker_stats.add("rtl"));
+        mySimParser.setTimeRange(dump_time_begin, dump_time_end);
+        myRtlParser.setTimeRange(dump_time_begin, dump_time_end);
+        if (!mySimParser.open(stream_write_csv) || !myRtlParser.open(stream_write_csv)) return 1;
+        if (!checkpoint_file.empty()) {
+            vcd_checkpoint checkpoint;
+            if (resume_checkpoint) {
+                if (!checkpoint.load(checkpoint_file) || !mySimParser.restoreState(checkpoint, "sim") ||
+                    !myRtlParser.restoreState(checkpoint, "rtl")) return 1;
+                myComparator.resumeFrom(checkpoint);
+                std::cout << "Resuming at cycle " << checkpoint.getNumber("compare.cycle") << std::endl;
+            }
+            myComparator.setCheckpoint(checkpoint_file, checkpoint_every, [&](vcd_checkpoint& cp) {
+                mySimParser.saveState(cp, "sim");
+                myRtlParser.saveState(cp, "rtl");
+            });
+        }
+
+        std::cout << "\n--- Starting Streaming Signal Comparison ---" << std::endl;
+        if (stream_pipelined && !checkpoint_file.empty()) {
+            std::cout << "Note: stream_pipelined is off while checkpoint_file is set, the checkpointed positions "
+                         "must match the compared cycle" << std::endl;
+        }
+        if (stream_pipelined && checkpoint_file.empty()) {
+            pipelined_source<sim_core_vcd_conv> simRows(mySimParser);
+            pipelined_source<rtl_core_vcd_conv> rtlRows(myRtlParser);
+            myComparator.compareStreams(simRows, rtlRows, compareMap);
+        } else {
+            myComparator.compareStreams(mySimParser, myRtlParser, compareMap);
+        }
+        return !myComparator.complete() || mySimParser.hasFailed() || myRtlParser.hasFailed() ? 1 : 0;
+    }
     std::cout << "\n--- Starting Signal Comparison ---" << std::endl;
+    if (use_binary_trace) {
+        myComparator.compareTraces("simulation_core.vtr", "rtl_core.vtr", compareMap);
+        return myComparator.complete() ? 0 : 1;
+    }
     myComparator.compare("simulation_core.csv", "rtl_core.csv", compareMap);
-    return 0;
+    return myComparator.complete() ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    checker_stats.startProgress(progress_seconds);
+    int status = run_checks(argc, argv);
+    checker_stats.stopProgress();
+    if (!stats_file.empty()) checker_stats.writeJson(stats_file);
+    return status;
 }
\ No newline at end of file
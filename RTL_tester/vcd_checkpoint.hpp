@@ -0,0 +1,103 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <map>
+#include <cstdio>
+#include <cstdint>
+
+// Saved state of an interrupted comparison: a flat set of "key value" lines, one per entry. The
+// converters and signal_comparator each store their part under their own key prefix, e.g.
+//
+//   VCDCKPT1
+//   rtl.offset 734003200
+//   rtl.value.cpu_top_tb.dut.u_cpu.u_writeback.pc_in 10000000000000000000000000110100
+//   compare.cycle 1048576
+//
+// Keys never contain spaces (VCD names cannot); a value runs to the end of its line.
+class vcd_checkpoint {
+private:
+    std::map<std::string, std::string> entries;
+
+public:
+    void set(const std::string& key, const std::string& value) { entries[key] = value; }
+    void set(const std::string& key, long long value) { entries[key] = std::to_string(value); }
+
+    bool has(const std::string& key) const { return entries.count(key) != 0; }
+
+    std::string get(const std::string& key, const std::string& fallback = "") const {
+        auto it = entries.find(key);
+        return it == entries.end() ? fallback : it->second;
+    }
+
+    long long getNumber(const std::string& key, long long fallback = 0) const {
+        auto it = entries.find(key);
+        return it == entries.end() ? fallback : std::stoll(it->second);
+    }
+
+    // Entries under prefix, with the prefix removed from the keys
+    std::map<std::string, std::string> section(const std::string& prefix) const {
+        std::map<std::string, std::string> found;
+        for (auto it = entries.lower_bound(prefix); it != entries.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            found.emplace(it->first.substr(prefix.size()), it->second);
+        }
+        return found;
+    }
+
+    // Written to a temporary file and renamed over path, so a run killed while saving leaves the
+    // previous checkpoint intact
+    bool save(const std::string& path) const {
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp);
+            if (!out) {
+                std::cerr << "Error: Could not write checkpoint " << tmp << std::endl;
+                return false;
+            }
+            out << "VCDCKPT1\n";
+            for (const auto& [key, value] : entries) out << key << ' ' << value << '\n';
+            if (!out.flush()) return false;
+        }
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        std::string line;
+        if (!in || !std::getline(in, line) || line != "VCDCKPT1") {
+            std::cerr << "Error: " << path << " is not a checkpoint file." << std::endl;
+            return false;
+        }
+        entries.clear();
+        while (std::getline(in, line)) {
+            size_t sp = line.find(' ');
+            if (sp == std::string::npos) entries[line] = "";
+            else entries[line.substr(0, sp)] = line.substr(sp + 1);
+        }
+        return true;
+    }
+
+    // FNV-1a of a byte range
+    static uint64_t fingerprint(std::string_view bytes, uint64_t h = 14695981039346656037ULL) {
+        for (unsigned char c : bytes) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    // Fingerprint of the bytes a saved file offset was reached through, so a resume can tell whether the
+    // dump was rewritten before that point or only grew past it. Hashing the whole prefix would read as
+    // much as re-parsing it, so 16 blocks spread over it are hashed, the last one ending at the offset.
+    static uint64_t prefixFingerprint(std::string_view file, size_t offset) {
+        const size_t block = 4096, samples = 16;
+        uint64_t h = fingerprint(std::string_view());
+        for (size_t i = 1; i <= samples; ++i) {
+            size_t end = offset / samples * i + (i == samples ? offset % samples : 0);
+            size_t begin = end < block ? 0 : end - block;
+            h = fingerprint(file.substr(begin, end - begin), h);
+        }
+        return h;
+    }
+};
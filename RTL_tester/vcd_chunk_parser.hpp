@@ -0,0 +1,155 @@
+#pragma once
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "vcd_lexer.hpp"
+#include "vcd_symbol_table.hpp"
+#include "vcd_value.hpp"
+
+// Parallel parser for the value-change section of a VCD. The section is cut into chunks at
+// "#timestamp" line starts and a wave of chunks is parsed at once, one thread per chunk. A chunk
+// does not know the signal values at its start, so it records, per slot, how many samples it had
+// taken before the slot first changed; those samples and the clock edge decision for the chunk's
+// first clock change are patched in order once the previous chunk's end state is known. Samples
+// come out through onSample in exactly the order a sequential pass would produce them.
+//
+// Only value changes are handled here: $scope/$var commands after $enddefinitions are ignored.
+class vcd_chunk_parser {
+private:
+    static constexpr size_t notWritten = static_cast<size_t>(-1);
+
+    struct Chunk {
+        std::string_view text;
+        std::vector<vcd_value> value;        // last value per slot, meaningful once written
+        std::vector<size_t> firstWrite;      // samples taken before the slot's first change
+        std::vector<vcd_value> samples;      // active.size() values per sample
+        size_t sampleCount = 0;
+        uint64_t changes = 0;                // value changes in the chunk, tracked or not
+        bool firstEdgeTentative = false;     // sample 0 needs the start clock value to be 0
+    };
+
+    const vcd_symbol_table& symbols;
+    std::vector<vcd_value> state;
+    std::vector<int> active;
+    int clock;
+    uint64_t resolvedBytes = 0;
+    uint64_t changeCount = 0;
+
+    void parseChunk(Chunk& ch) const {
+        const size_t slots = state.size();
+        const size_t width = active.size();
+        ch.value = state;
+        ch.firstWrite.assign(slots, notWritten);
+        ch.samples.clear();
+        ch.sampleCount = 0;
+        ch.changes = 0;
+        ch.firstEdgeTentative = false;
+
+        vcd_lexer lexer(ch.text);
+        vcd_token tok;
+        while (lexer.next(tok)) {
+            if (tok.kind != vcd_token::Scalar && tok.kind != vcd_token::Vector) continue;
+            ch.changes++;
+            int slot = symbols.find(tok.id);
+            if (slot == vcd_symbol_table::untracked) continue;
+
+            vcd_value& v = ch.value[slot];
+            bool known = ch.firstWrite[slot] != notWritten;
+            bool wasLow = known && v.isZero();
+            if (tok.kind == vcd_token::Vector) v.assignBinary(tok.value);
+            else v.assignScalar(tok.value[0]);
+            if (!known) ch.firstWrite[slot] = ch.sampleCount;
+
+            if (slot != clock || !v.isOne()) continue;
+            if (!known) ch.firstEdgeTentative = true;
+            else if (!wasLow) continue;
+
+            size_t base = ch.samples.size();
+            ch.samples.resize(base + width);
+            for (size_t i = 0; i < width; ++i) {
+                if (ch.firstWrite[active[i]] != notWritten) ch.samples[base + i] = ch.value[active[i]];
+            }
+            ch.sampleCount++;
+        }
+    }
+
+    // Fills in values that were inherited from before the chunk and advances state to its end
+    template <typename SampleFn>
+    long resolveChunk(Chunk& ch, SampleFn& onSample) {
+        const size_t width = active.size();
+        size_t first = 0;
+        resolvedBytes += ch.text.size();
+        changeCount += ch.changes;
+        if (ch.firstEdgeTentative && !state[clock].isZero()) first = 1;
+
+        for (size_t k = first; k < ch.sampleCount; ++k) {
+            vcd_value* sample = ch.samples.data() + k * width;
+            for (size_t i = 0; i < width; ++i) {
+                if (k < ch.firstWrite[active[i]]) sample[i] = state[active[i]];
+            }
+            onSample(static_cast<const vcd_value*>(sample));
+        }
+
+        for (size_t s = 0; s < state.size(); ++s) {
+            if (ch.firstWrite[s] != notWritten) state[s] = ch.value[s];
+        }
+        return (long)(ch.sampleCount - first);
+    }
+
+    static const char* nextBoundary(const char* p, const char* end) {
+        while (p < end) {
+            const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (nl == nullptr || nl + 1 >= end) return end;
+            if (nl[1] == '#') return nl + 1;
+            p = nl + 1;
+        }
+        return end;
+    }
+
+public:
+    // state: value of every slot at the start of text (its widths are reused); active: the sampled
+    // slots in column order; clock: slot whose rising edge triggers a sample
+    vcd_chunk_parser(const vcd_symbol_table& symbolTable, std::vector<vcd_value> initialState,
+                     std::vector<int> activeSlots, int clockSlot)
+        : symbols(symbolTable), state(std::move(initialState)), active(std::move(activeSlots)), clock(clockSlot) {}
+
+    // Returns the number of samples delivered; onSample(const vcd_value*) runs on the calling thread
+    template <typename SampleFn>
+    long run(std::string_view text, int threads, size_t chunkBytes, SampleFn onSample) {
+        if (clock < 0) return 0;
+        if (threads < 1) threads = 1;
+        if (chunkBytes == 0) chunkBytes = 1;
+
+        std::vector<Chunk> wave(threads);
+        const char* p = text.data();
+        const char* end = text.data() + text.size();
+        long total = 0;
+
+        while (p < end) {
+            int used = 0;
+            for (; used < threads && p < end; ++used) {
+                const char* stop = (size_t)(end - p) <= chunkBytes ? end : nextBoundary(p + chunkBytes, end);
+                wave[used].text = std::string_view(p, stop - p);
+                p = stop;
+            }
+
+            std::vector<std::thread> workers;
+            for (int i = 1; i < used; ++i) workers.emplace_back([this, &wave, i] { parseChunk(wave[i]); });
+            parseChunk(wave[0]);
+            for (auto& w : workers) w.join();
+
+            for (int i = 0; i < used; ++i) total += resolveChunk(wave[i], onSample);
+        }
+        return total;
+    }
+
+    // Bytes and value changes of the chunks resolved so far, readable from onSample
+    uint64_t bytesResolved() const { return resolvedBytes; }
+    uint64_t valueChanges() const { return changeCount; }
+
+    // Signal values after the last parsed chunk
+    const std::vector<vcd_value>& finalState() const { return state; }
+};
@@ -0,0 +1,675 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <set>
+#include <deque>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include "mapped_file.hpp"
+#include "compressed_file.hpp"
+#include "vcd_lexer.hpp"
+#include "vcd_symbol_table.hpp"
+#include "vcd_value.hpp"
+#include "vcd_chunk_parser.hpp"
+#include "vcd_trace_file.hpp"
+#include "vcd_checkpoint.hpp"
+#include "vcd_signal_selector.hpp"
+#include "run_stats.hpp"
+
+// Policies of a converter flavour. A scope joiner builds the full name of a $var from the open scopes,
+// a clock detector picks the sampling clock by its name, and a sink receives the finished rows. They
+// are template parameters, so the header and hot value-change loop are compiled for each flavour.
+
+// "top.cpu.u_alu.result". The open scopes are kept as one prefix ("top.cpu.u_alu."), extended on
+// $scope and cut back on $upscope, so a $var only appends its own name.
+struct dotted_scope_path {
+    static void enter(std::string& prefix, std::string_view scope) {
+        prefix += scope;
+        prefix += '.';
+    }
+    static void join(std::string& fullPath, const std::string& prefix, std::string_view name) {
+        fullPath.assign(prefix);
+        fullPath += name;
+    }
+};
+
+struct common_clock_names {
+    static bool isClock(std::string_view name) { return name == "Clock" || name == "clk" || name == "clk_i"; }
+};
+
+// Rows as CSV (header before the first row) and/or binary trace; an empty path is not written
+class vcd_file_sink {
+private:
+    std::ofstream csvFile;
+    vcd_trace_writer traceFile;
+    std::vector<std::string> header;
+    std::string csvLine;
+    bool headerWritten = false;
+
+public:
+    // False when a file could not be created
+    bool open(const std::string& csv, const std::string& trace, const std::vector<std::string>& columns,
+              const std::vector<unsigned>& widths) {
+        header = columns;
+        if (!csv.empty()) {
+            csvFile.open(csv);
+            if (!csvFile.is_open()) {
+                std::cerr << "Error: Could not create " << csv << std::endl;
+                return false;
+            }
+        }
+        return trace.empty() || traceFile.open(trace, columns, widths);
+    }
+
+    void write(const std::vector<vcd_value>& row) {
+        if (csvFile.is_open()) {
+            csvLine.clear();
+            if (!headerWritten) {
+                for (size_t i = 0; i < header.size(); ++i) csvLine += header[i] + (i == header.size() - 1 ? "" : ",");
+                csvLine += '\n';
+                headerWritten = true;
+            }
+            for (size_t i = 0; i < row.size(); ++i) {
+                row[i].appendText(csvLine);
+                if (i != row.size() - 1) csvLine += ',';
+            }
+            csvLine += '\n';
+            csvFile << csvLine;
+        }
+        if (traceFile.is_open()) traceFile.append(row);
+    }
+
+    void close() {
+        traceFile.close();
+        if (csvFile.is_open()) csvFile.close();
+    }
+
+    // Printed at the end of run()
+    void summary(const std::string& csv, int cycles) const {
+        std::cout << "CSV Generated: " << csv << " (" << cycles << " cycles)." << std::endl;
+    }
+};
+
+// One clock domain of a converter: rows of signals taken on the chosen edges of clock, only while
+// enable (e.g. a valid strobe) is 1. Names are selector patterns, like the target signals.
+struct vcd_sample_domain {
+    enum Edge { Rising = 1, Falling = 2, Both = 3 };
+
+    std::string name;                   // output suffix, e.g. "mem" -> rtl_core_mem.csv
+    std::string clock;
+    Edge edge = Rising;
+    std::string enable;                 // empty = every edge
+    std::set<std::string> signals;
+};
+
+// VCD to sampled rows: selects the target signals, samples them on every rising edge of the clock
+// and groups cyclesPerRow edges into one row, for nextRow() or the sink. With sample domains the
+// rows are taken per domain instead, each written to its own outputs. Target and domain signal names
+// are vcd_signal_selector patterns: path suffixes, globs or "re:" regexes.
+template <typename ScopeJoiner, typename ClockDetector, typename Sink = vcd_file_sink>
+class vcd_converter {
+private:
+    std::string inputVcd;
+    std::string outputCsv;
+    std::string outputTrace;
+    std::set<std::string> targetSignals;
+    int cyclesPerRow;
+    int parseThreads = 1;
+    size_t chunkBytes = size_t(64) << 20;
+
+    struct SignalInfo {
+        std::string fullName;
+        vcd_value lastValue;
+        bool isClock = false;
+    };
+
+    // A configured domain resolved against the dump header
+    struct Domain {
+        vcd_sample_domain config;
+        int clock = vcd_symbol_table::untracked;
+        int enable = vcd_symbol_table::untracked;
+        std::vector<int> slots;
+        std::vector<std::string> columns;
+        std::vector<vcd_value> row;
+        int samples = 0;
+        Sink sink;
+    };
+
+    static constexpr int risingEdge = vcd_sample_domain::Rising;
+    static constexpr int fallingEdge = vcd_sample_domain::Falling;
+
+    // Parser state, kept across nextRow() calls so the dump is consumed one edge at a time
+    mapped_file vcdFile;
+    compressed_file compressedVcd;      // .vcd.gz / .vcd.zst input, read through the lexer window
+    vcd_lexer lexer;
+    Sink sink;
+    vcd_symbol_table symbolTable;
+    std::vector<SignalInfo> signals;
+    std::vector<int> activeSymbols;
+    std::string scopePrefix;
+    std::vector<size_t> scopeLengths;       // scopePrefix length before each open $scope
+    std::string fullPath;
+    std::vector<vcd_value> rowBuffer;
+    std::vector<std::string> columns;
+    int clkSymbol = vcd_symbol_table::untracked;
+    std::string clockPattern;               // setClock(); empty = ClockDetector picks the clock by name
+    int clockUse = -1;                      // its index in uses
+    bool clockAmbiguous = false;
+    int cycleCounter = 0;
+    std::deque<Domain> domains;
+    std::vector<std::vector<int>> clockedDomains;   // per slot: the domains it clocks
+
+    // Target signals and domain names compiled into one selector; uses[i] is what pattern i selects
+    struct PatternUse {
+        enum Kind { Target, Clock, Enable, Signal } kind;
+        int domain;
+    };
+    vcd_signal_selector selector;
+    std::vector<PatternUse> uses;
+    std::vector<int> matched;
+    size_t selectedDomain = 0;
+    std::vector<int> sampledDomains;    // domains that took a row on the last edge; from sampledNext not yet returned
+    size_t sampledNext = 0;
+    const char* bodyStart = nullptr;    // first value change after the header
+    uint64_t currentTime = 0;
+    uint64_t rangeBegin = 0, rangeEnd = UINT64_MAX;
+    bool pastRange = false;
+    bool failureReported = false;
+
+    // Published to stageStats once per row
+    stage_stats* stageStats = nullptr;
+    uint64_t valueChanges = 0;
+    uint64_t rowCount = 0;
+    stage_stats::mark bodyStarted;
+    bool bodyTimed = false;
+
+    void buildSelector() {
+        selector = vcd_signal_selector();
+        uses.clear();
+        clockUse = -1;
+        for (const std::string& target : targetSignals) {
+            if (target == clockPattern) clockUse = (int)uses.size();
+            selector.add(target);
+            uses.push_back({PatternUse::Target, -1});
+        }
+        for (size_t d = 0; d < domains.size(); ++d) {
+            selector.add(domains[d].config.clock);
+            uses.push_back({PatternUse::Clock, (int)d});
+            if (!domains[d].config.enable.empty()) {
+                selector.add(domains[d].config.enable);
+                uses.push_back({PatternUse::Enable, (int)d});
+            }
+            for (const std::string& signal : domains[d].config.signals) {
+                selector.add(signal);
+                uses.push_back({PatternUse::Signal, (int)d});
+            }
+        }
+    }
+
+    void parseCommand(const vcd_token& tok) {
+        std::string_view rest = tok.body;
+        if (tok.keyword == "scope") {
+            std::string_view type, name;
+            vcd_lexer::nextWord(rest, type);
+            vcd_lexer::nextWord(rest, name);
+            scopeLengths.push_back(scopePrefix.size());
+            ScopeJoiner::enter(scopePrefix, name);
+        } 
+        else if (tok.keyword == "upscope") {
+            if (!scopeLengths.empty()) {
+                scopePrefix.resize(scopeLengths.back());
+                scopeLengths.pop_back();
+            }
+        }
+        else if (tok.keyword == "var") {
+            std::string_view type, size, sym, name;
+            vcd_lexer::nextWord(rest, type);
+            vcd_lexer::nextWord(rest, size);
+            vcd_lexer::nextWord(rest, sym);
+            vcd_lexer::nextWord(rest, name);
+
+            ScopeJoiner::join(fullPath, scopePrefix, name);
+            selector.match(fullPath, matched);
+            if (matched.empty()) return;
+
+            // Targets were added first, so they have the lowest pattern indices
+            if (uses[matched[0]].kind == PatternUse::Target) {
+                int slot = symbolTable.find(sym);
+                if (slot == vcd_symbol_table::untracked) {
+                    slot = (int)signals.size();
+                    signals.emplace_back();
+                    symbolTable.assign(sym, slot);
+                }
+                unsigned width = 1;
+                std::from_chars(size.data(), size.data() + size.size(), width);
+                signals[slot] = {fullPath, vcd_value(width)};
+                activeSymbols.push_back(slot);
+                if (clockUse < 0) {
+                    if (ClockDetector::isClock(name)) clkSymbol = slot;
+                } else if (std::find(matched.begin(), matched.end(), clockUse) != matched.end()) {
+                    if (clkSymbol >= 0 && clkSymbol != slot) clockAmbiguous = true;
+                    else clkSymbol = slot;
+                }
+            }
+
+            int lastSignalDomain = -1;      // a $var is one column of a domain, however many patterns match
+            for (int id : matched) {
+                const PatternUse& use = uses[id];
+                if (use.kind == PatternUse::Target) continue;
+                Domain& dom = domains[use.domain];
+                if (use.kind == PatternUse::Clock && dom.clock < 0) dom.clock = trackSlot(sym, size, fullPath);
+                if (use.kind == PatternUse::Enable && dom.enable < 0) dom.enable = trackSlot(sym, size, fullPath);
+                if (use.kind == PatternUse::Signal && use.domain != lastSignalDomain) {
+                    dom.slots.push_back(trackSlot(sym, size, fullPath));
+                    dom.columns.push_back(fullPath);
+                    lastSignalDomain = use.domain;
+                }
+            }
+        }
+    }
+
+    // Slot of a signal only used by a domain; an identifier already tracked keeps its slot and name
+    int trackSlot(std::string_view sym, std::string_view size, const std::string& fullPath) {
+        int slot = symbolTable.find(sym);
+        if (slot != vcd_symbol_table::untracked) return slot;
+        slot = (int)signals.size();
+        unsigned width = 1;
+        std::from_chars(size.data(), size.data() + size.size(), width);
+        signals.push_back({fullPath, vcd_value(width)});
+        symbolTable.assign(sym, slot);
+        return slot;
+    }
+
+    // Applies one value change; returns the edges it made if the signal is a clock, else 0
+    int applyValueChange(const vcd_token& tok, int& slot) {
+        slot = symbolTable.find(tok.id);
+        if (slot == vcd_symbol_table::untracked) return 0;
+
+        SignalInfo& sig = signals[slot];
+        vcd_value& lastValue = sig.lastValue;
+        if (!sig.isClock) {
+            if (tok.kind == vcd_token::Vector) lastValue.assignBinary(tok.value);
+            else lastValue.assignScalar(tok.value[0]);
+            return 0;
+        }
+        bool wasLow = lastValue.isZero(), wasHigh = lastValue.isOne();
+        if (tok.kind == vcd_token::Vector) lastValue.assignBinary(tok.value);
+        else lastValue.assignScalar(tok.value[0]);
+        return (wasLow && lastValue.isOne() ? risingEdge : 0) | (wasHigh && lastValue.isZero() ? fallingEdge : 0);
+    }
+
+    // Records a row in every domain clocked by slot on one of these edges while its enable is set, and
+    // lists those domains in sampledDomains
+    void sampleDomains(int slot, int edges) {
+        sampledDomains.clear();
+        sampledNext = 0;
+        for (int d : clockedDomains[slot]) {
+            Domain& dom = domains[d];
+            if (!(edges & dom.config.edge)) continue;
+            if (dom.enable >= 0) {
+                const vcd_value& en = signals[dom.enable].lastValue;
+                if (!en.isKnown() || en.isZero()) continue;
+            }
+            dom.row.resize(dom.slots.size());
+            for (size_t i = 0; i < dom.slots.size(); ++i) dom.row[i] = signals[dom.slots[i]].lastValue;
+            dom.samples++;
+            rowCount++;
+            dom.sink.write(dom.row);
+            sampledDomains.push_back(d);
+        }
+    }
+
+    // rtl_core.csv -> rtl_core_mem.csv
+    static std::string domainPath(const std::string& path, const std::string& domain) {
+        if (path.empty()) return path;
+        size_t dot = path.find_last_of('.');
+        size_t slash = path.find_last_of('/');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return path + "_" + domain;
+        return path.substr(0, dot) + "_" + domain + path.substr(dot);
+    }
+
+    bool openDomains(bool writeCsv) {
+        clockedDomains.assign(signals.size(), {});
+        for (size_t d = 0; d < domains.size(); ++d) {
+            Domain& dom = domains[d];
+            if (dom.clock < 0 || (!dom.config.enable.empty() && dom.enable < 0)) {
+                std::cerr << "Error: clock or enable of domain " << dom.config.name << " not found in " << inputVcd << std::endl;
+                return false;
+            }
+            signals[dom.clock].isClock = true;
+            clockedDomains[dom.clock].push_back((int)d);
+
+            std::vector<unsigned> widths;
+            for (int s : dom.slots) widths.push_back(signals[s].lastValue.width());
+            if (!dom.sink.open(writeCsv ? domainPath(outputCsv, dom.config.name) : "", domainPath(outputTrace, dom.config.name),
+                               dom.columns, widths)) return false;
+        }
+        return true;
+    }
+
+    // Row assembly shared by the sequential and parallel paths: beginSample() returns where the
+    // active values of the next sampled edge go, endSample() completes it and writes finished rows.
+    vcd_value* beginSample() {
+        if (rowBuffer.size() != columns.size()) rowBuffer.resize(columns.size());
+        return rowBuffer.data() + (cycleCounter % cyclesPerRow) * activeSymbols.size();
+    }
+
+    bool endSample() {
+        cycleCounter++;
+        if (cycleCounter % cyclesPerRow != 0) return false;
+        rowCount++;
+        sink.write(rowBuffer);
+        return true;
+    }
+
+    uint64_t bytesRead() const {
+        return vcdFile.is_open() ? lexer.position() - vcdFile.data() : compressedVcd.bytesDecoded();
+    }
+
+    void publishStats(uint64_t bytes) {
+        if (stageStats == nullptr) return;
+        stageStats->set(stage_stats::Bytes, bytes);
+        stageStats->set(stage_stats::ValueChanges, valueChanges);
+        stageStats->set(stage_stats::Rows, rowCount);
+    }
+
+    // End of the value changes: the body phase runs from the first nextRow() call. A compressed dump that
+    // stopped on a decode error is reported here once; hasFailed() tells the caller.
+    bool endOfRows() {
+        if (hasFailed() && !failureReported) {
+            std::cerr << "Error: " << inputVcd << " ends early after " << rowCount << " rows, the rest of the dump is missing" << std::endl;
+            failureReported = true;
+        }
+        publishStats(bytesRead());
+        if (stageStats != nullptr && bodyTimed) {
+            stageStats->addPhase("body", bodyStarted);
+            stageStats->finish();
+            bodyTimed = false;
+        }
+        return false;
+    }
+
+    // Applies value changes up to the next clock edge in the time range; slot is the clock and edges
+    // the edges it made. False at the end of the rows.
+    bool nextEdge(int& slot, int& edges) {
+        if (pastRange) return false;
+        if (stageStats != nullptr && !bodyTimed && !stageStats->isFinished()) {
+            bodyStarted = stage_stats::mark::now();
+            bodyTimed = true;
+        }
+        vcd_token tok;
+        while (lexer.next(tok)) {
+            if (tok.kind == vcd_token::Command) {
+                parseCommand(tok);
+                continue;
+            }
+            if (tok.kind == vcd_token::Timestamp) {
+                std::from_chars(tok.value.data(), tok.value.data() + tok.value.size(), currentTime);
+                if (currentTime >= rangeEnd) {
+                    pastRange = true;
+                    return endOfRows();
+                }
+                continue;
+            }
+            if (tok.kind != vcd_token::Scalar && tok.kind != vcd_token::Vector) continue;
+            valueChanges++;
+            edges = applyValueChange(tok, slot);
+            if (edges != 0 && currentTime >= rangeBegin) return true;
+        }
+        return endOfRows();
+    }
+
+    void runParallel() {
+        std::vector<vcd_value> state;
+        for (const auto& sig : signals) state.push_back(sig.lastValue);
+
+        // CPU time of the body phase is that of all threads, the chunk workers included
+        stage_stats::timer body(stageStats, "body", true);
+        uint64_t bodyOffset = bytesRead();
+        vcd_chunk_parser parser(symbolTable, std::move(state), activeSymbols, clkSymbol);
+        parser.run(lexer.rest(), parseThreads, chunkBytes, [this, &parser, bodyOffset](const vcd_value* sample) {
+            vcd_value* dst = beginSample();
+            for (size_t i = 0; i < activeSymbols.size(); ++i) dst[i] = sample[i];
+            if (endSample()) {
+                valueChanges = parser.valueChanges();
+                publishStats(bodyOffset + parser.bytesResolved());
+            }
+        });
+        for (size_t i = 0; i < signals.size(); ++i) signals[i].lastValue = parser.finalState()[i];
+        valueChanges = parser.valueChanges();
+        publishStats(vcdFile.size());
+        if (stageStats != nullptr) stageStats->finish();
+    }
+
+public:
+    vcd_converter(std::string vcd, std::string csv, std::set<std::string> signals, int groupSize = 1) 
+        : inputVcd(vcd), outputCsv(csv), targetSignals(signals), cyclesPerRow(groupSize) {}
+
+    // Streaming interface: open() consumes the VCD header, nextRow() then returns one sampled
+    // row (cyclesPerRow rising edges) at a time. With writeCsv the rows are also written to
+    // outputCsv as a side product. False when the dump or an output file could not be opened.
+    bool open(bool writeCsv = true) {
+        stage_stats::timer header(stageStats, "header");
+        if (compressed_file::detect(inputVcd) != compressed_file::Plain) {
+            if (!compressedVcd.open(inputVcd)) return false;
+            lexer = vcd_lexer(compressedVcd);
+        } else {
+            if (!vcdFile.open(inputVcd)) {
+                std::cerr << "Error: Could not open " << inputVcd << std::endl;
+                return false;
+            }
+            lexer = vcd_lexer(vcdFile.view());
+            if (stageStats != nullptr) stageStats->setTotalBytes(vcdFile.size());
+        }
+
+        // Header ends at $enddefinitions; anything after is left for nextRow()
+        buildSelector();
+        vcd_token tok;
+        while (lexer.next(tok)) {
+            if (tok.kind != vcd_token::Command) {
+                lexer.unread();
+                break;
+            }
+            if (tok.keyword == "enddefinitions") break;
+            parseCommand(tok);
+        }
+        if (hasFailed()) return false;
+        if (clockAmbiguous) {
+            std::cerr << "Error: clock " << clockPattern << " matches several signals in " << inputVcd << std::endl;
+            return false;
+        }
+        bodyStart = lexer.position();
+        publishStats(bytesRead());
+        if (!domains.empty()) return openDomains(writeCsv);
+        if (clkSymbol >= 0) signals[clkSymbol].isClock = true;
+
+        for (int c = 0; c < cyclesPerRow; ++c) {
+            for (int s : activeSymbols) {
+                columns.push_back(signals[s].fullName + (cyclesPerRow > 1 ? "_C" + std::to_string(c) : ""));
+            }
+        }
+
+        std::vector<unsigned> widths;
+        for (int c = 0; c < cyclesPerRow; ++c) {
+            for (int s : activeSymbols) widths.push_back(signals[s].lastValue.width());
+        }
+        return sink.open(writeCsv ? outputCsv : "", outputTrace, columns, widths);
+    }
+
+    using value_type = vcd_value;
+
+    // Parse the value-change section of run() on several threads; the CSV is identical to the
+    // single-threaded output. Compressed dumps are decoded on their own threads and parsed sequentially.
+    void setParseThreads(int threads, size_t chunkSize = size_t(64) << 20) {
+        parseThreads = threads;
+        chunkBytes = chunkSize;
+    }
+
+    // Publish bytes read, value changes and rows to stage while parsing, and time the header, body
+    // (first to last nextRow(), or the parallel parse of run()) and close phases; set before open().
+    // Streamed rows are pulled by their consumer, so in lockstep mode the body phase includes its work.
+    void setStats(stage_stats* stage) { stageStats = stage; }
+
+    // Also write the sampled rows as a binary columnar trace (see vcd_trace_file.hpp); set before open()
+    void setTraceOutput(const std::string& path) { outputTrace = path; }
+
+    // Only sample rising edges at dump times in [begin, end); earlier value changes are applied without
+    // building rows, and the first row is cycle 0. Set before reading rows; run() then parses sequentially.
+    void setTimeRange(uint64_t begin, uint64_t end = UINT64_MAX) {
+        rangeBegin = begin;
+        rangeEnd = end;
+    }
+
+    // Sample per clock domain instead of on the rising edges of the detected clock; add before open().
+    // Domains ignore cyclesPerRow (one sample per row) and are parsed sequentially.
+    void addDomain(const vcd_sample_domain& domain) {
+        domains.emplace_back();
+        domains.back().config = domain;
+    }
+
+    // nextRow() and columnNames() give the rows of this domain; the others only go to their outputs
+    void selectDomain(size_t index) { selectedDomain = index; }
+
+    size_t domainCount() const { return domains.size(); }
+    const std::vector<std::string>& domainColumns(size_t index) const { return domains[index].columns; }
+    int domainSamples(size_t index) const { return domains[index].samples; }
+
+    const std::vector<std::string>& columnNames() const {
+        return domains.empty() ? columns : domains[selectedDomain].columns;
+    }
+    int cyclesSampled() const { return cycleCounter; }
+
+    // Sample on the rising edges of this signal, a selector pattern like the target signals (and added
+    // to them), instead of the target ClockDetector finds by name; set before open(). open() fails if
+    // the pattern matches more than one signal.
+    void setClock(const std::string& pattern) {
+        clockPattern = pattern;
+        targetSignals.insert(pattern);
+    }
+
+    // False when open() found no clock among the target signals, so no rows will be sampled
+    bool hasClock() const { return clkSymbol >= 0 || !domains.empty(); }
+
+    // Full name of the signal rows are sampled on, empty without one (or with sample domains)
+    const std::string& clockName() const {
+        static const std::string none;
+        return clkSymbol >= 0 ? signals[clkSymbol].fullName : none;
+    }
+
+    // True when the dump is compressed and decoding stopped on an error: open() or the rows ended early
+    bool hasFailed() const { return compressedVcd.hasFailed(); }
+
+    // Parse position between two rows: byte offset into the dump, cycle and time reached, and the last
+    // value of every selected signal. Fingerprints of the header and of the bytes before the offset
+    // let restoreState() reject a dump that was rewritten rather than extended.
+    // Compressed dumps cannot be entered at an offset and are not checkpointed.
+    void saveState(vcd_checkpoint& cp, const std::string& prefix) const {
+        if (!vcdFile.is_open()) return;
+        size_t offset = lexer.position() - vcdFile.data();
+        cp.set(prefix + ".file", inputVcd);
+        cp.set(prefix + ".offset", (long long)offset);
+        cp.set(prefix + ".header", std::to_string(vcd_checkpoint::fingerprint(std::string_view(vcdFile.data(), bodyStart - vcdFile.data()))));
+        cp.set(prefix + ".prefix", std::to_string(vcd_checkpoint::prefixFingerprint(vcdFile.view(), offset)));
+        cp.set(prefix + ".cycle", cycleCounter);
+        cp.set(prefix + ".time", (long long)currentTime);
+        for (const Domain& dom : domains) cp.set(prefix + ".samples." + dom.config.name, dom.samples);
+        std::string bits;
+        for (const SignalInfo& sig : signals) {
+            bits.clear();
+            sig.lastValue.appendBits(bits);
+            cp.set(prefix + ".value." + sig.fullName, bits);
+        }
+    }
+
+    // Continue from a saveState() checkpoint instead of the start of the dump; call after open()
+    bool restoreState(const vcd_checkpoint& cp, const std::string& prefix) {
+        if (!vcdFile.is_open()) {
+            std::cerr << "Error: checkpoints need an uncompressed dump, " << inputVcd << " is compressed" << std::endl;
+            return false;
+        }
+        const char* base = vcdFile.data();
+        long long offset = cp.getNumber(prefix + ".offset", -1);
+        bool matches = offset >= bodyStart - base && offset <= (long long)vcdFile.size();
+        if (matches) {
+            matches = cp.get(prefix + ".header") == std::to_string(vcd_checkpoint::fingerprint(std::string_view(base, bodyStart - base))) &&
+                      cp.get(prefix + ".prefix") == std::to_string(vcd_checkpoint::prefixFingerprint(vcdFile.view(), offset));
+        }
+        for (size_t i = 0; matches && i < signals.size(); ++i) matches = cp.has(prefix + ".value." + signals[i].fullName);
+        if (!matches) {
+            std::cerr << "Error: checkpoint does not match " << inputVcd << std::endl;
+            return false;
+        }
+
+        for (SignalInfo& sig : signals) sig.lastValue.assignBinary(cp.get(prefix + ".value." + sig.fullName));
+        cycleCounter = (int)cp.getNumber(prefix + ".cycle");
+        currentTime = cp.getNumber(prefix + ".time");
+        for (Domain& dom : domains) dom.samples = (int)cp.getNumber(prefix + ".samples." + dom.config.name);
+        lexer.seek(base + offset);
+        return true;
+    }
+
+    // Next row of any sample domain and the index of that domain, so one pass over the dump can feed a
+    // consumer per domain. Domains sampled on the same edge are returned in the order they were added.
+    bool nextDomainRow(std::vector<vcd_value>& row, size_t& domain) {
+        int slot, edges;
+        while (sampledNext == sampledDomains.size()) {
+            if (!nextEdge(slot, edges)) return false;
+            sampleDomains(slot, edges);
+        }
+        domain = sampledDomains[sampledNext++];
+        row.swap(domains[domain].row);
+        publishStats(bytesRead());
+        return true;
+    }
+
+    bool nextRow(std::vector<vcd_value>& row) {
+        if (!domains.empty()) {
+            size_t domain;
+            while (nextDomainRow(row, domain)) {
+                if (domain != selectedDomain) continue;
+                cycleCounter++;
+                return true;
+            }
+            return false;
+        }
+        int slot, edges;
+        while (nextEdge(slot, edges)) {
+            if (!(edges & risingEdge)) continue;
+
+            // Values are copied into a reused row; text is only produced for the CSV side output
+            vcd_value* dst = beginSample();
+            for (int s : activeSymbols) *dst++ = signals[s].lastValue;
+            if (endSample()) {
+                row.swap(rowBuffer);
+                publishStats(bytesRead());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // False when the dump could not be read to its end; the outputs are then incomplete
+    bool run() {
+        if (!open(true)) return false;
+        if (parseThreads > 1 && vcdFile.is_open() && domains.empty() && rangeBegin == 0 && rangeEnd == UINT64_MAX) runParallel();
+        else {
+            std::vector<vcd_value> row;
+            while (nextRow(row)) {}
+        }
+        stage_stats::timer close(stageStats, "close");
+        bool complete = !hasFailed();
+        if (domains.empty()) {
+            sink.close();
+            if (complete) sink.summary(outputCsv, cycleCounter);
+        }
+        for (Domain& dom : domains) {
+            dom.sink.close();
+            if (complete) dom.sink.summary(domainPath(outputCsv, dom.config.name), dom.samples);
+        }
+        return complete;
+    }
+};
@@ -0,0 +1,148 @@
+#pragma once
+#include <string_view>
+#include <cstddef>
+
+// One lexical item of a VCD file. All views point into the buffer given to vcd_lexer.
+struct vcd_token {
+    enum Kind { Timestamp, Scalar, Vector, Real, Command };
+
+    Kind kind = Command;
+    std::string_view value;    // Timestamp: digits after '#', Scalar: the value char, Vector: bits after 'b'
+    std::string_view id;       // identifier code of a value change
+    std::string_view keyword;  // Command: keyword without '$', e.g. "var", "scope", "dumpvars"
+    std::string_view body;     // Command: text between the keyword and its $end
+};
+
+// Input that arrives piece by piece (e.g. a decompressing reader) instead of as one buffer
+class vcd_stream {
+public:
+    virtual ~vcd_stream() = default;
+
+    // Keeps the bytes from keep (nullptr = none) to the end of the current window, appends more input
+    // after them and returns the new window in begin/end, with begin at the kept bytes. Returns false
+    // at the end of input, leaving the window as it was.
+    virtual bool refill(const char* keep, const char*& begin, const char*& end) = 0;
+};
+
+// Zero-copy tokenizer over an in-memory VCD (usually a mapped_file). Header commands are returned
+// whole with their body; $dumpvars/$dumpall/$dumpon/$dumpoff only open a block of ordinary value
+// changes, so they come back with an empty body and the closing $end is skipped.
+//
+// Over a vcd_stream the buffer is a window that is refilled whenever a token reaches its end, so the
+// views of a token are only valid until the next call to next().
+class vcd_lexer {
+private:
+    const char* cur;
+    const char* end;
+    const char* last = nullptr;     // start of the token returned last
+    vcd_stream* stream = nullptr;
+
+    static bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+    void skipSpace() {
+        while (cur < end && isSpace(*cur)) ++cur;
+    }
+
+    std::string_view word() {
+        const char* start = cur;
+        while (cur < end && !isSpace(*cur)) ++cur;
+        return std::string_view(start, cur - start);
+    }
+
+    static bool opensValueBlock(std::string_view kw) {
+        return kw == "dumpvars" || kw == "dumpall" || kw == "dumpon" || kw == "dumpoff";
+    }
+
+public:
+    vcd_lexer() : cur(nullptr), end(nullptr) {}
+    explicit vcd_lexer(std::string_view text) : cur(text.data()), end(text.data() + text.size()) {}
+    explicit vcd_lexer(vcd_stream& input) : cur(nullptr), end(nullptr), stream(&input) {}
+
+    const char* position() const { return cur; }
+    void seek(const char* p) { cur = p; }
+    std::string_view rest() const { return std::string_view(cur, end - cur); }
+
+    // Steps back so the token returned last is read again
+    void unread() { cur = last; }
+
+    // Returns false at end of input
+    bool next(vcd_token& tok) {
+        skipSpace();
+        last = cur;
+        if (stream == nullptr) return scan(tok);
+        for (;;) {
+            const char* start = cur;
+            // A token is only complete when something follows it in the window; otherwise it may go on
+            // in the next piece of input, so it is scanned again after the refill
+            if (scan(tok) && cur < end) return true;
+            if (!stream->refill(start, cur, end)) {
+                cur = start;
+                return scan(tok);
+            }
+            last = cur;
+        }
+    }
+
+private:
+    bool scan(vcd_token& tok) {
+        for (;;) {
+            skipSpace();
+            if (cur >= end) return false;
+
+            std::string_view w = word();
+            char c = w[0];
+
+            if (c == '$') {
+                std::string_view kw = w.substr(1);
+                if (kw == "end") continue;
+
+                tok.kind = vcd_token::Command;
+                tok.keyword = kw;
+                tok.body = std::string_view();
+                if (opensValueBlock(kw)) return true;
+
+                // Body runs to the next standalone $end
+                skipSpace();
+                const char* bodyStart = cur;
+                const char* bodyEnd = cur;
+                while (cur < end) {
+                    std::string_view b = word();
+                    if (b == "$end") break;
+                    bodyEnd = cur;
+                    skipSpace();
+                }
+                tok.body = std::string_view(bodyStart, bodyEnd - bodyStart);
+                return true;
+            }
+            if (c == '#') {
+                tok.kind = vcd_token::Timestamp;
+                tok.value = w.substr(1);
+                return true;
+            }
+            if (c == 'b' || c == 'B' || c == 'r' || c == 'R' || c == 's' || c == 'S') {
+                tok.kind = (c == 'b' || c == 'B') ? vcd_token::Vector : vcd_token::Real;
+                tok.value = w.substr(1);
+                skipSpace();
+                tok.id = word();
+                return true;
+            }
+            tok.kind = vcd_token::Scalar;
+            tok.value = w.substr(0, 1);
+            tok.id = w.substr(1);
+            return true;
+        }
+    }
+
+public:
+    // Splits the next whitespace-separated word off a command body
+    static bool nextWord(std::string_view& rest, std::string_view& out) {
+        size_t i = 0;
+        while (i < rest.size() && isSpace(rest[i])) ++i;
+        if (i == rest.size()) return false;
+        size_t j = i;
+        while (j < rest.size() && !isSpace(rest[j])) ++j;
+        out = rest.substr(i, j - i);
+        rest = rest.substr(j);
+        return true;
+    }
+};
@@ -0,0 +1,146 @@
+#pragma once
+#include <algorithm>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Matches full signal paths against a set of patterns. Every pattern selects the paths it matches the
+// end of, like a plain suffix test ("u_writeback.pc_in" selects "top.dut.u_cpu.u_writeback.pc_in"):
+//
+//   u_writeback.pc_in          exact name
+//   u_writeback.*              glob: * any run of characters (dots included), ? one character, [a-z] / [!0-9]
+//   re:u_cpu[0-9]+\.rd_.*      ECMAScript regex, searched at the end of the path
+//
+// Exact names are stored reversed in a trie and looked up by walking the path from its last character,
+// so the cost per path does not grow with the number of names. Globs and regexes are tried one by one.
+class vcd_signal_selector {
+private:
+    struct Node {
+        std::vector<std::pair<char, int>> next;
+        std::vector<int> patterns;          // exact names ending here
+    };
+    std::vector<Node> trie{1};
+    struct Glob {
+        std::string pattern;
+        std::string literal;                // longest run without wildcards, checked first
+        int id;
+    };
+    std::vector<Glob> globs;
+    std::vector<std::pair<std::regex, int>> regexes;
+    int count = 0;
+
+    static bool isGlob(const std::string& pattern) { return pattern.find_first_of("*?[") != std::string::npos; }
+
+    int child(int node, char c) const {
+        for (const auto& [k, n] : trie[node].next) {
+            if (k == c) return n;
+        }
+        return -1;
+    }
+
+    // Character class at glob[p] ("[...]"); returns whether c is in it and moves p past it
+    static bool matchClass(std::string_view glob, size_t& p, char c) {
+        size_t i = p + 1;
+        bool negate = i < glob.size() && (glob[i] == '!' || glob[i] == '^');
+        if (negate) ++i;
+        size_t first = i;
+        bool found = false;
+        while (i < glob.size() && (glob[i] != ']' || i == first)) {
+            if (i + 2 < glob.size() && glob[i + 1] == '-' && glob[i + 2] != ']') {
+                found = found || (c >= glob[i] && c <= glob[i + 2]);
+                i += 3;
+            } else {
+                found = found || c == glob[i];
+                ++i;
+            }
+        }
+        if (i >= glob.size()) {             // no closing ']': a literal '['
+            p += 1;
+            return c == '[';
+        }
+        p = i + 1;
+        return found != negate;
+    }
+
+    // True when glob matches text from some position to its end, i.e. "*" + glob matches all of text
+    static bool matchGlobSuffix(std::string_view glob, std::string_view text) {
+        size_t p = 0, t = 0;
+        size_t starP = 0, starT = 0;        // the implied leading '*'
+        while (t < text.size()) {
+            if (p < glob.size() && glob[p] == '*') {
+                starP = ++p;
+                starT = t;
+                continue;
+            }
+            if (p < glob.size()) {
+                size_t q = p + 1;
+                bool ok = glob[p] == '[' ? matchClass(glob, q = p, text[t]) : glob[p] == '?' || glob[p] == text[t];
+                if (ok) {
+                    p = q;
+                    ++t;
+                    continue;
+                }
+            }
+            // Let the last '*' take one more character
+            p = starP;
+            t = ++starT;
+        }
+        while (p < glob.size() && glob[p] == '*') ++p;
+        return p == glob.size();
+    }
+
+public:
+    // Index of the new pattern; match() reports patterns by these indices
+    int add(const std::string& pattern) {
+        int id = count++;
+        if (pattern.compare(0, 3, "re:") == 0) {
+            regexes.emplace_back(std::regex("(?:" + pattern.substr(3) + ")$", std::regex::ECMAScript | std::regex::optimize), id);
+        } else if (isGlob(pattern)) {
+            Glob g{pattern, "", id};
+            for (size_t i = 0; i < pattern.size();) {
+                size_t end = pattern.find_first_of("*?[", i);
+                if (end == std::string::npos) end = pattern.size();
+                if (end - i > g.literal.size()) g.literal = pattern.substr(i, end - i);
+                i = end;
+                if (i < pattern.size() && pattern[i] == '[') i = pattern.find(']', i + 2);
+                if (i != std::string::npos && i < pattern.size()) ++i;
+            }
+            globs.push_back(std::move(g));
+        } else {
+            int node = 0;
+            for (auto c = pattern.rbegin(); c != pattern.rend(); ++c) {
+                int n = child(node, *c);
+                if (n < 0) {
+                    n = (int)trie.size();
+                    trie[node].next.emplace_back(*c, n);
+                    trie.emplace_back();
+                }
+                node = n;
+            }
+            trie[node].patterns.push_back(id);
+        }
+        return id;
+    }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Indices of all patterns that match path, in ascending order
+    void match(std::string_view path, std::vector<int>& matched) const {
+        matched.clear();
+        int node = 0;
+        for (size_t i = path.size(); i-- > 0 && node >= 0;) {
+            node = child(node, path[i]);
+            if (node >= 0) matched.insert(matched.end(), trie[node].patterns.begin(), trie[node].patterns.end());
+        }
+        for (const Glob& g : globs) {
+            if (path.find(g.literal) != std::string_view::npos && matchGlobSuffix(g.pattern, path)) matched.push_back(g.id);
+        }
+        for (const auto& [re, id] : regexes) {
+            if (std::regex_search(path.begin(), path.end(), re)) matched.push_back(id);
+        }
+        if (matched.size() > 1) std::sort(matched.begin(), matched.end());
+    }
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstddef>
+
+// Maps VCD identifier codes to slots of the caller's signal array. Codes are strings over printable
+// ASCII ('!'..'~'), read here as bijective base-94 numbers, so every code decodes to a unique dense
+// index and a lookup is one array read. Codes that decode past maxDenseIndex (or use characters
+// outside that range) go to a small side table that is still looked up without allocating.
+class vcd_symbol_table {
+public:
+    static constexpr int untracked = -1;
+    static constexpr size_t maxDenseIndex = size_t(1) << 24;
+
+private:
+    std::vector<int> dense;
+    std::deque<std::string> overflowKeys;
+    std::unordered_map<std::string_view, int> overflow;
+
+public:
+    static bool decode(std::string_view code, size_t& index) {
+        if (code.empty()) return false;
+        size_t n = 0;
+        for (char c : code) {
+            if (c < '!' || c > '~') return false;
+            n = n * 94 + static_cast<size_t>(c - '!' + 1);
+            if (n > maxDenseIndex) return false;
+        }
+        index = n - 1;
+        return true;
+    }
+
+    void assign(std::string_view code, int slot) {
+        size_t index;
+        if (decode(code, index)) {
+            if (index >= dense.size()) dense.resize(index + 1, untracked);
+            dense[index] = slot;
+            return;
+        }
+        auto it = overflow.find(code);
+        if (it != overflow.end()) {
+            it->second = slot;
+            return;
+        }
+        overflowKeys.emplace_back(code);
+        overflow.emplace(overflowKeys.back(), slot);
+    }
+
+    // Slot for a code, or untracked
+    int find(std::string_view code) const {
+        size_t index;
+        if (decode(code, index)) return index < dense.size() ? dense[index] : untracked;
+        if (overflow.empty()) return untracked;
+        auto it = overflow.find(code);
+        return it == overflow.end() ? untracked : it->second;
+    }
+};
@@ -0,0 +1,222 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "mapped_file.hpp"
+#include "vcd_value.hpp"
+
+// Binary columnar trace: the sampled rows of a converter without the decimal text of a CSV.
+//
+//   header : "VCDTRC1\0", uint32 columns, uint32 blockRows,
+//            per column: uint32 width, uint32 nameLength, name bytes
+//   blocks : uint32 rows, then per column one block of that column's values for those rows:
+//            uint8 flags, value plane, [unknown plane]
+//
+// Every value in a column block has the same size, (width + 7) / 8 bytes per plane (little-endian,
+// as on the x86 hosts this runs on). flags bit 0 marks a block that contains x/z bits and so also
+// stores the unknown plane; bit 1 marks a block whose values are all identical, stored once.
+// Clocks, enables and idle buses are constant over most blocks, so they cost a few bytes per block.
+namespace vcd_trace {
+    constexpr char magic[8] = {'V', 'C', 'D', 'T', 'R', 'C', '1', '\0'};
+    constexpr uint8_t hasUnknown = 1;
+    constexpr uint8_t constant = 2;
+}
+
+class vcd_trace_writer {
+private:
+    std::ofstream out;
+    std::vector<unsigned> widths;
+    uint32_t blockRows;
+    std::vector<std::vector<vcd_value>> pending;   // per column, rows of the open block
+    uint32_t pendingRows = 0;
+    std::string block;
+
+    template <typename T>
+    static void put(std::string& buf, T v) { buf.append(reinterpret_cast<const char*>(&v), sizeof(v)); }
+
+    void flushBlock() {
+        if (pendingRows == 0) return;
+        block.clear();
+        put<uint32_t>(block, pendingRows);
+        for (size_t c = 0; c < pending.size(); ++c) {
+            const std::vector<vcd_value>& col = pending[c];
+            uint8_t flags = vcd_trace::constant;
+            for (uint32_t r = 0; r < pendingRows; ++r) {
+                if (!col[r].isKnown()) flags |= vcd_trace::hasUnknown;
+                if (r > 0 && col[r] != col[0]) flags &= ~vcd_trace::constant;
+            }
+            block += (char)flags;
+
+            uint32_t n = (flags & vcd_trace::constant) ? 1 : pendingRows;
+            size_t bytes = col[0].planeBytes();
+            for (uint32_t r = 0; r < n; ++r) block.append(static_cast<const char*>(col[r].valuePlane()), bytes);
+            if (flags & vcd_trace::hasUnknown) {
+                for (uint32_t r = 0; r < n; ++r) block.append(static_cast<const char*>(col[r].unknownPlane()), bytes);
+            }
+        }
+        out.write(block.data(), block.size());
+        pendingRows = 0;
+    }
+
+public:
+    vcd_trace_writer() = default;
+    ~vcd_trace_writer() { close(); }
+
+    bool open(const std::string& path, const std::vector<std::string>& names, const std::vector<unsigned>& columnWidths,
+              uint32_t rowsPerBlock = 4096) {
+        out.open(path, std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << "Error: Could not create " << path << std::endl;
+            return false;
+        }
+        widths = columnWidths;
+        blockRows = rowsPerBlock == 0 ? 1 : rowsPerBlock;
+        pending.assign(names.size(), std::vector<vcd_value>(blockRows));
+        for (size_t c = 0; c < names.size(); ++c) {
+            for (auto& v : pending[c]) v.setWidth(widths[c]);
+        }
+
+        std::string header(vcd_trace::magic, sizeof(vcd_trace::magic));
+        put<uint32_t>(header, (uint32_t)names.size());
+        put<uint32_t>(header, blockRows);
+        for (size_t c = 0; c < names.size(); ++c) {
+            put<uint32_t>(header, widths[c]);
+            put<uint32_t>(header, (uint32_t)names[c].size());
+            header += names[c];
+        }
+        out.write(header.data(), header.size());
+        return true;
+    }
+
+    bool is_open() const { return out.is_open(); }
+
+    void append(const std::vector<vcd_value>& row) {
+        for (size_t c = 0; c < pending.size(); ++c) pending[c][pendingRows] = row[c];
+        if (++pendingRows == blockRows) flushBlock();
+    }
+
+    void close() {
+        if (!out.is_open()) return;
+        flushBlock();
+        out.close();
+    }
+};
+
+// Memory-mapped reader; a row source like the converters (columnNames()/nextRow()), so
+// signal_comparator::compareStreams() can compare traces with each other or with a live VCD.
+class vcd_trace_reader {
+public:
+    using value_type = vcd_value;
+
+private:
+    mapped_file file;
+    std::vector<std::string> columns;
+    std::vector<unsigned> widths;
+    const unsigned char* cur = nullptr;
+    const unsigned char* end = nullptr;
+
+    // Current block: per column the start of its value / unknown planes
+    struct ColumnBlock {
+        const unsigned char* values = nullptr;
+        const unsigned char* unknowns = nullptr;
+        size_t stride = 0;                     // 0 for constant blocks
+    };
+    std::vector<ColumnBlock> blockCols;
+    uint32_t blockRowCount = 0;
+    uint32_t blockRow = 0;
+    std::string path;
+
+    bool badHeader(const char* reason) {
+        std::cerr << "Error: " << path << ": " << reason << std::endl;
+        return false;
+    }
+
+    bool truncatedBlock() {
+        std::cerr << "Error: " << path << ": truncated block at byte " << (cur - reinterpret_cast<const unsigned char*>(file.data()))
+                  << ", the rows after it are missing" << std::endl;
+        cur = end;
+        return false;
+    }
+
+    template <typename T>
+    bool get(T& v) {
+        if ((size_t)(end - cur) < sizeof(T)) return false;
+        std::memcpy(&v, cur, sizeof(T));
+        cur += sizeof(T);
+        return true;
+    }
+
+    // False at the end of the file, or with a message when the last block is cut short
+    bool loadBlock() {
+        if (cur == end) return false;
+        uint32_t rows;
+        if (!get(rows) || rows == 0) return truncatedBlock();
+        for (size_t c = 0; c < columns.size(); ++c) {
+            uint8_t flags;
+            if (!get(flags)) return truncatedBlock();
+            size_t bytes = (widths[c] + 7) / 8;
+            size_t n = (flags & vcd_trace::constant) ? 1 : rows;
+            size_t planes = (flags & vcd_trace::hasUnknown) ? 2 : 1;
+            if ((size_t)(end - cur) < n * bytes * planes) return truncatedBlock();
+
+            ColumnBlock& cb = blockCols[c];
+            cb.values = cur;
+            cb.unknowns = (flags & vcd_trace::hasUnknown) ? cur + n * bytes : nullptr;
+            cb.stride = (flags & vcd_trace::constant) ? 0 : bytes;
+            cur += n * bytes * planes;
+        }
+        blockRowCount = rows;
+        blockRow = 0;
+        return true;
+    }
+
+public:
+    bool open(const std::string& tracePath) {
+        path = tracePath;
+        if (!file.open(path)) {
+            std::cerr << "Error: Could not open " << path << std::endl;
+            return false;
+        }
+        cur = reinterpret_cast<const unsigned char*>(file.data());
+        end = cur + file.size();
+
+        uint32_t count, blockRows;
+        if ((size_t)(end - cur) < sizeof(vcd_trace::magic)) return badHeader("too short for a trace header");
+        if (std::memcmp(cur, vcd_trace::magic, sizeof(vcd_trace::magic)) != 0) return badHeader("not a binary trace (bad magic)");
+        cur += sizeof(vcd_trace::magic);
+        if (!get(count) || !get(blockRows)) return badHeader("header cut short before the column count");
+        for (uint32_t c = 0; c < count; ++c) {
+            uint32_t width, nameLength;
+            if (!get(width) || !get(nameLength) || (size_t)(end - cur) < nameLength) {
+                return badHeader(("header cut short in column " + std::to_string(c) + " of " + std::to_string(count)).c_str());
+            }
+            if (width == 0) return badHeader(("column " + std::to_string(c) + " has width 0").c_str());
+            widths.push_back(width);
+            columns.emplace_back(reinterpret_cast<const char*>(cur), nameLength);
+            cur += nameLength;
+        }
+        blockCols.resize(count);
+        return true;
+    }
+
+    const std::vector<std::string>& columnNames() const { return columns; }
+    const std::vector<unsigned>& columnWidths() const { return widths; }
+
+    bool nextRow(std::vector<vcd_value>& row) {
+        if (blockRow == blockRowCount && !loadBlock()) return false;
+        // The caller may have reused row for another source, so widths are checked on every row
+        row.resize(columns.size());
+        for (size_t c = 0; c < columns.size(); ++c) {
+            if (row[c].width() != widths[c]) row[c].setWidth(widths[c]);
+            const ColumnBlock& cb = blockCols[c];
+            size_t offset = cb.stride * blockRow;
+            row[c].loadPlanes(cb.values + offset, cb.unknowns ? cb.unknowns + offset : nullptr);
+        }
+        blockRow++;
+        return true;
+    }
+};
@@ -0,0 +1,237 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+// Packed 4-state bit vector. Each bit is stored in two planes: val and unk.
+//   unk=0 -> val is the 0/1 value,  unk=1,val=0 -> x,  unk=1,val=1 -> z
+// Buses up to 128 bits live inline; wider ones use a heap buffer whose capacity is reused on every
+// assignment, so steady-state value changes never allocate. Bits above the width are kept at zero,
+// which lets vectors of different widths compare as zero-extended words.
+class vcd_value {
+public:
+    static constexpr unsigned inlineWords = 2;
+
+private:
+    unsigned bits = 1;
+    unsigned words = 1;
+    uint64_t inlineBuf[2 * inlineWords] = {};
+    std::vector<uint64_t> wideBuf;
+
+    uint64_t* val() { return words <= inlineWords ? inlineBuf : wideBuf.data(); }
+    uint64_t* unk() { return val() + words; }
+    const uint64_t* val() const { return words <= inlineWords ? inlineBuf : wideBuf.data(); }
+    const uint64_t* unk() const { return val() + words; }
+
+    uint64_t topMask() const {
+        unsigned r = bits % 64;
+        return r == 0 ? ~uint64_t(0) : (uint64_t(1) << r) - 1;
+    }
+
+    bool highWordsZero() const {
+        const uint64_t* v = val();
+        for (unsigned w = 1; w < words; ++w) if (v[w]) return false;
+        return true;
+    }
+
+    void clear() {
+        uint64_t* v = val();
+        std::memset(v, 0, 2 * words * sizeof(uint64_t));
+    }
+
+    // Fills bits [from, width) with x (or z)
+    void fillUnknown(unsigned from, bool z) {
+        uint64_t* v = val();
+        uint64_t* u = unk();
+        for (unsigned w = from / 64; w < words; ++w) {
+            uint64_t m = ~uint64_t(0);
+            if (w == from / 64) m <<= (from % 64);
+            if (w == words - 1) m &= topMask();
+            u[w] |= m;
+            if (z) v[w] |= m;
+        }
+    }
+
+public:
+    vcd_value() = default;
+    explicit vcd_value(unsigned width) { setWidth(width); }
+
+    unsigned width() const { return bits; }
+
+    // Resets the value to all zeros with the given width
+    void setWidth(unsigned width) {
+        bits = width == 0 ? 1 : width;
+        words = (bits + 63) / 64;
+        if (words > inlineWords) wideBuf.assign(2 * words, 0);
+        else wideBuf.clear();
+        clear();
+    }
+
+    // Single VCD value character; l/h are taken as 0/1, any other unknown state as x
+    void assignScalar(char c) {
+        clear();
+        switch (c) {
+        case '1': case 'h': case 'H': val()[0] = 1; break;
+        case '0': case 'l': case 'L': break;
+        case 'z': case 'Z': val()[0] = 1; unk()[0] = 1; break;
+        default: unk()[0] = 1; break;
+        }
+    }
+
+    // Binary digits as written after 'b' in a VCD, MSB first. Shorter strings are left-extended
+    // with 0, or with x/z when the leftmost digit is x/z; longer strings keep the low bits.
+    void assignBinary(std::string_view digits) {
+        clear();
+        if (digits.empty()) return;
+        uint64_t* v = val();
+        uint64_t* u = unk();
+
+        size_t n = digits.size() < bits ? digits.size() : bits;
+        const char* p = digits.data() + digits.size();
+        for (size_t i = 0; i < n; ++i) {
+            char c = *--p;
+            uint64_t m = uint64_t(1) << (i % 64);
+            switch (c) {
+            case '1': v[i / 64] |= m; break;
+            case '0': break;
+            case 'z': case 'Z': v[i / 64] |= m; u[i / 64] |= m; break;
+            default: u[i / 64] |= m; break;
+            }
+        }
+
+        char lead = digits[0];
+        if (n < bits && lead != '0' && lead != '1') fillUnknown((unsigned)n, lead == 'z' || lead == 'Z');
+    }
+
+    // Known unsigned value, truncated to the width
+    void assignUnsigned(uint64_t v) {
+        clear();
+        val()[0] = bits < 64 ? v & ((uint64_t(1) << bits) - 1) : v;
+    }
+
+    bool isKnown() const {
+        const uint64_t* u = unk();
+        for (unsigned w = 0; w < words; ++w) if (u[w]) return false;
+        return true;
+    }
+
+    // Known value equal to 0 / 1, used for clock edge detection
+    bool isZero() const {
+        const uint64_t* v = val();
+        for (unsigned w = 0; w < words; ++w) if (v[w]) return false;
+        return isKnown();
+    }
+
+    bool isOne() const {
+        return val()[0] == 1 && highWordsZero() && isKnown();
+    }
+
+    // Raw planes as little-endian bytes: (width + 7) / 8 bytes each, bits above the width are zero
+    size_t planeBytes() const { return (bits + 7) / 8; }
+    const void* valuePlane() const { return val(); }
+    const void* unknownPlane() const { return unk(); }
+
+    // Inverse of valuePlane()/unknownPlane(); a null unknown plane means fully known
+    void loadPlanes(const void* valueBytes, const void* unknownBytes) {
+        clear();
+        std::memcpy(val(), valueBytes, planeBytes());
+        if (unknownBytes != nullptr) std::memcpy(unk(), unknownBytes, planeBytes());
+    }
+
+    // Low 64 bits of a known value
+    uint64_t low64() const { return val()[0]; }
+
+    // 4-state case equality (x matches only x, z only z) on zero-extended words
+    bool operator==(const vcd_value& o) const {
+        const uint64_t* v1 = val();
+        const uint64_t* u1 = unk();
+        const uint64_t* v2 = o.val();
+        const uint64_t* u2 = o.unk();
+        unsigned n = words > o.words ? words : o.words;
+        for (unsigned w = 0; w < n; ++w) {
+            uint64_t a = w < words ? v1[w] : 0, b = w < o.words ? v2[w] : 0;
+            uint64_t ua = w < words ? u1[w] : 0, ub = w < o.words ? u2[w] : 0;
+            if (a != b || ua != ub) return false;
+        }
+        return true;
+    }
+    bool operator!=(const vcd_value& o) const { return !(*this == o); }
+
+    // Text form for CSVs and reports: unsigned decimal when fully known, "x"/"z" when every bit is
+    // x/z, otherwise the bits MSB first with a 'b' prefix.
+    void appendText(std::string& out) const {
+        const uint64_t* v = val();
+        const uint64_t* u = unk();
+
+        if (isKnown()) {
+            char buf[24];
+            if (highWordsZero()) {
+                auto res = std::to_chars(buf, buf + sizeof(buf), v[0]);
+                out.append(buf, res.ptr - buf);
+                return;
+            }
+            // Wide value: peel off base-1e19 digits by long division
+            std::vector<uint64_t> num(v, v + words);
+            std::vector<uint64_t> chunks;
+            const uint64_t base = 10000000000000000000ULL;
+            bool nonZero = true;
+            while (nonZero) {
+                unsigned __int128 rem = 0;
+                nonZero = false;
+                for (size_t w = num.size(); w-- > 0;) {
+                    unsigned __int128 cur = (rem << 64) | num[w];
+                    num[w] = (uint64_t)(cur / base);
+                    rem = cur % base;
+                    if (num[w]) nonZero = true;
+                }
+                chunks.push_back((uint64_t)rem);
+            }
+            auto res = std::to_chars(buf, buf + sizeof(buf), chunks.back());
+            out.append(buf, res.ptr - buf);
+            for (size_t i = chunks.size() - 1; i-- > 0;) {
+                res = std::to_chars(buf, buf + sizeof(buf), chunks[i]);
+                out.append(19 - (res.ptr - buf), '0');
+                out.append(buf, res.ptr - buf);
+            }
+            return;
+        }
+
+        bool allX = true, allZ = true;
+        for (unsigned w = 0; w < words; ++w) {
+            uint64_t m = (w == words - 1) ? topMask() : ~uint64_t(0);
+            if ((u[w] & m) != m) allX = allZ = false;
+            if (v[w] & m) allX = false;
+            if ((v[w] & m) != m) allZ = false;
+        }
+        if (allX) { out += 'x'; return; }
+        if (allZ) { out += 'z'; return; }
+
+        out += 'b';
+        appendBits(out);
+    }
+
+    // Every bit MSB first (0/1/x/z), the exact form assignBinary() reads back
+    void appendBits(std::string& out) const {
+        const uint64_t* v = val();
+        const uint64_t* u = unk();
+        for (unsigned i = bits; i-- > 0;) {
+            uint64_t m = uint64_t(1) << (i % 64);
+            bool bv = v[i / 64] & m, bu = u[i / 64] & m;
+            out += bu ? (bv ? 'z' : 'x') : (bv ? '1' : '0');
+        }
+    }
+
+    std::string toString() const {
+        std::string s;
+        appendText(s);
+        return s;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const vcd_value& v) {
+    return os << v.toString();
+}
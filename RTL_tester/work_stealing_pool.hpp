@@ -0,0 +1,148 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads, each with its own deque of jobs. A worker runs its newest job first and,
+// once its deque is empty, steals the oldest job of another worker, so long and short jobs even out
+// without every worker contending on one shared queue. A job submitted from inside a job goes to the
+// deque of the worker running it.
+class work_stealing_pool {
+public:
+    using job = std::function<void()>;
+
+private:
+    struct Worker {
+        std::mutex lock;
+        std::deque<job> jobs;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex stateLock;
+    std::condition_variable wake;           // jobs queued or stopping
+    std::condition_variable allDone;        // pending reached 0
+    std::atomic<long> queued{0};            // in a deque; briefly negative while a batch is dealt
+    size_t pending = 0;                     // submitted and not finished; under stateLock
+    size_t nextWorker = 0;
+    bool stopping = false;
+
+    inline static thread_local work_stealing_pool* currentPool = nullptr;
+    inline static thread_local size_t currentWorker = 0;
+
+    bool take(size_t self, job& j) {
+        {
+            Worker& own = *workers[self];
+            std::lock_guard<std::mutex> g(own.lock);
+            if (!own.jobs.empty()) {
+                j = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < workers.size(); ++k) {
+            Worker& victim = *workers[(self + k) % workers.size()];
+            std::lock_guard<std::mutex> g(victim.lock);
+            if (!victim.jobs.empty()) {
+                j = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(size_t self) {
+        currentPool = this;
+        currentWorker = self;
+        for (;;) {
+            job j;
+            if (take(self, j)) {
+                queued.fetch_sub(1);
+                j();
+                std::lock_guard<std::mutex> g(stateLock);
+                if (--pending == 0) allDone.notify_all();
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(stateLock);
+            wake.wait(lk, [this] { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0) return;
+        }
+    }
+
+public:
+    explicit work_stealing_pool(int threadCount = std::thread::hardware_concurrency()) {
+        size_t n = threadCount < 1 ? 1 : threadCount;
+        for (size_t i = 0; i < n; ++i) workers.push_back(std::make_unique<Worker>());
+        for (size_t i = 0; i < n; ++i) threads.emplace_back([this, i] { run(i); });
+    }
+
+    // Finishes every submitted job first
+    ~work_stealing_pool() {
+        wait();
+        {
+            std::lock_guard<std::mutex> g(stateLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // From outside the pool, jobs are dealt to the workers in turn
+    void submit(job j) {
+        size_t target;
+        {
+            std::lock_guard<std::mutex> g(stateLock);
+            pending++;
+            target = currentPool == this ? currentWorker : nextWorker++ % workers.size();
+        }
+        {
+            std::lock_guard<std::mutex> g(workers[target]->lock);
+            workers[target]->jobs.push_back(std::move(j));
+        }
+        {
+            std::lock_guard<std::mutex> g(stateLock);
+            queued.fetch_add(1);
+        }
+        wake.notify_all();
+    }
+
+    // A set of jobs, dealt to the workers in turn and only woken for once all are queued, so a worker
+    // starts with the last job it was dealt
+    void submit(std::vector<job> batch) {
+        {
+            std::lock_guard<std::mutex> g(stateLock);
+            pending += batch.size();
+        }
+        size_t target = 0;
+        for (job& j : batch) {
+            {
+                std::lock_guard<std::mutex> g(stateLock);
+                target = nextWorker++ % workers.size();
+            }
+            std::lock_guard<std::mutex> g(workers[target]->lock);
+            workers[target]->jobs.push_back(std::move(j));
+        }
+        {
+            std::lock_guard<std::mutex> g(stateLock);
+            queued.fetch_add((long)batch.size());
+        }
+        wake.notify_all();
+    }
+
+    // Blocks until every submitted job, including jobs they submitted, has finished; not from inside a job
+    void wait() {
+        std::unique_lock<std::mutex> lk(stateLock);
+        allDone.wait(lk, [this] { return pending == 0; });
+    }
+};
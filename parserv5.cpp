@@ -1,9 +1,18 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <sstream>
+#include <string_view>
 #include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
 #include <chrono>
+#include <charconv>
+#include <cstdint>
+#include "RTL_tester/mapped_file.hpp"
+#include "RTL_tester/spsc_queue.hpp"
+#include "RTL_tester/run_stats.hpp"
 
 using namespace std;
 using namespace std::chrono;
@@ -18,134 +27,488 @@ struct instruction_trace {
     uint32_t reg_data=0; // use uint_32 becuase some reg use full range due to storing mem addr
     uint32_t mem_addr=0;
     uint32_t mem_data=0;
-    string   mnemonic;
+    string_view mnemonic; // raw text after the instruction word, points into the mapped trace log
+    long commit_lineno = 0, trace_lineno = 0; // source lines, 0 = not seen in that log
+    bool closed = false;  // can no longer be matched, written as it is
 };
 
-vector<instruction_trace> instr_list;
+// Rows not yet written, in output order. The two logs are joined on (core, PC, instruction word): a
+// record from one log waits here for its line from the other. Both logs list instructions in the same
+// order, so once a record is matched, every older record still waiting can never be matched and is
+// closed. A record still unmatched once merge_window newer rows arrived is closed too (resync window).
+// Closed rows are reported on stderr; a commit row is still written without mnemonic, a trace line
+// that never committed (e.g. a trapping instruction) is left out of the CSV.
+deque<instruction_trace> instr_window;
+size_t merge_window = 1024;
 
-string commit_line, trace_line;
-int pt = 0;
-int line_count = 0;
+int boot_records = 5; // skip the first records of each hart in each log, the bootloader at the spike reset vector
+long max_diagnostics = 50;
+long unmatched_commits = 0, unmatched_traces = 0;
+atomic<long> ignored_lines{0}; // counted by both readers
 
-uint32_t hex_to_int(const string &s) {
-    if (s.empty()) return 0;
-    return static_cast<uint32_t>(stoul(s.substr(2, 8), nullptr, 16));
+string_view commit_line, trace_line;
+long commit_lineno = 0, trace_lineno = 0;
+vector<int> commit_records, trace_records; // records seen per core
+
+// Rows are formatted in place into data, which is kept at least as long as the rows written so far
+// (used) plus the next one, so a row costs no resize
+struct row_buffer {
+    string data;
+    size_t used = 0;
+};
+
+// A CSV file with its own writer thread. Rows are formatted into buf as they are merged; full 1 MB
+// blocks are handed to the writer, which only writes them out.
+struct csv_output {
+    ofstream file;
+    row_buffer buf;
+    spsc_queue<string> blocks{8};
+    thread writer; // not started if the file could not be created
+};
+unique_ptr<csv_output> merged_output;
+atomic<bool> cancel_writers{false};
+
+// Multi-hart runs: write one CSV per hart (core), spike_outv2_hart<N>.csv, instead of one interleaved file
+bool per_hart_output = false;
+vector<unique_ptr<csv_output>> hart_outputs;
+
+// Progress on stderr every progress_seconds (0 = never): bytes and lines of both logs read so far and
+// rows written. At the end the counters, the merge/write phase times and the peak memory are written to
+// output_filepath + stats_file (empty = not written).
+double progress_seconds = 10;
+string stats_file = "spike_outv2_stats.json";
+run_stats merge_stats;
+stage_stats &merge_stage = merge_stats.add("spike_merge");
+long rows_written = 0;
+
+// Value of each character as a hex digit, 16 for any other character
+struct hex_table {
+    uint8_t digit[256];
+    constexpr hex_table() : digit() {
+        for (int c = 0; c < 256; ++c) digit[c] = 16;
+        for (int c = '0'; c <= '9'; ++c) digit[c] = c - '0';
+        for (int c = 'a'; c <= 'f'; ++c) digit[c] = c - 'a' + 10;
+        for (int c = 'A'; c <= 'F'; ++c) digit[c] = c - 'A' + 10;
+    }
+};
+constexpr hex_table hex_digits;
+
+// "0x" followed by up to 8 hex digits, same as stoul(s.substr(2, 8), nullptr, 16)
+uint32_t hex_to_int(string_view s) {
+    if (s.size() <= 2) return 0;
+    const unsigned char *p = (const unsigned char *)s.data() + 2;
+    const unsigned char *end = (const unsigned char *)s.data() + min<size_t>(s.size(), 10);
+    uint32_t v = 0;
+    for (; p < end && hex_digits.digit[*p] < 16; ++p) v = (v << 4) | hex_digits.digit[*p];
+    return v;
 }
 
-int str_to_int(const string &s) {
-    if (s.empty()) return 0;
-    return stoi(s);
+int str_to_int(string_view s) {
+    int v = 0;
+    // Up to 9 digits cannot overflow: read them directly, stopping where from_chars() would
+    if (!s.empty() && s.size() < 10 && s[0] != '-') {
+        for (char c : s) {
+            if (c < '0' || c > '9') break;
+            v = v * 10 + (c - '0');
+        }
+        return v;
+    }
+    from_chars(s.data(), s.data() + s.size(), v);
+    return v;
 }
 
-int xreg_to_int(const string &reg_addr) {
+int xreg_to_int(string_view reg_addr) {
     if (reg_addr.empty() || reg_addr[0] != 'x') return 0;
-    return static_cast<int>(stoul(reg_addr.substr(1)));
+    return str_to_int(reg_addr.substr(1));
+}
+
+bool next_line(string_view &text, string_view &line) {
+    if (text.empty()) return false;
+    size_t nl = text.find('\n');
+    if (nl == string_view::npos) nl = text.size();
+    line = text.substr(0, nl);
+    text.remove_prefix(nl < text.size() ? nl + 1 : nl);
+    return true;
 }
 
-vector<string> split(const string &s, char delim = ' ') {
-    vector<string> tokens;
-    string token;
-    stringstream ss(s);
-    while (getline(ss, token, delim)) {
-        if (!token.empty()) tokens.push_back(token);
+// Reads the space-separated fields of a line one at a time, as views into it; empty fields are dropped
+// like the old split(). The fields are used as they are read, so a line is scanned once.
+struct field_reader {
+    const char *p, *end;
+    explicit field_reader(string_view line) : p(line.data()), end(line.data() + line.size()) {}
+
+    // Empty once the line has no more fields
+    string_view next() {
+        while (p < end && *p == ' ') ++p;
+        const char *start = p;
+        while (p < end && *p != ' ') ++p;
+        return string_view(start, p - start);
     }
-    return tokens;
+
+    // next(), with the field read as hex_to_int() reads it in the same pass
+    string_view next(uint32_t &hex) {
+        while (p < end && *p == ' ') ++p;
+        const char *start = p;
+        hex = 0;
+        if (end - p > 2 && p[1] != ' ') {
+            p += 2;
+            const char *digits_end = p + min<ptrdiff_t>(end - p, 8);
+            for (uint8_t d; p < digits_end && (d = hex_digits.digit[(unsigned char)*p]) < 16; ++p) hex = (hex << 4) | d;
+        }
+        while (p < end && *p != ' ') ++p;
+        return string_view(start, p - start);
+    }
+};
+
+// Counts a record of core; true while it is still part of that hart's bootloader
+bool in_boot(vector<int> &records, int core) {
+    if (core < 0) core = 0;
+    if ((size_t)core >= records.size()) records.resize(core + 1, 0);
+    return records[core]++ < boot_records;
+}
+
+bool is_hex(string_view s) {
+    return s.size() > 2 && s[0] == '0' && s[1] == 'x';
 }
 
-string remove_paren(const string &s) {
+string_view remove_paren(string_view s) {
     if (s.size() >= 2 && s.front() == '(' && s.back() == ')')
         return s.substr(1, s.size() - 2);
     return s;
 }
 
-int main() {
+template <typename Int>
+char *put_field(char *p, Int v) {
+    p = to_chars(p, p + 11, v).ptr;
+    *p++ = ',';
+    return p;
+}
+
+// Mnemonic tokens rejoined with single spaces, like the old split()-and-concatenate, in one pass
+char *put_mnemonic(char *p, string_view raw) {
+    const char *s = raw.data(), *end = raw.data() + raw.size();
+    while (s < end && *s == ' ') ++s;
+    bool gap = false;
+    for (; s < end; ++s) {
+        if (*s == ' ') {
+            gap = true;
+            continue;
+        }
+        if (gap) *p++ = ' ';
+        gap = false;
+        *p++ = *s;
+    }
+    return p;
+}
+
+// The longest possible row: 8 numbers of up to 11 characters with their commas, the quotes and
+// newline, and the mnemonic
+void append_row(row_buffer &out, const instruction_trace &i) {
+    size_t longest = 8 * 12 + 3 + i.mnemonic.size();
+    if (out.data.size() < out.used + longest) out.data.resize(max<size_t>(out.used + longest, 1 << 20));
+    char *p = &out.data[out.used];
+    p = put_field(p, i.core);
+    p = put_field(p, i.thread);
+    p = put_field(p, i.proramming_cnt);
+    p = put_field(p, i.instruction_hex);
+    p = put_field(p, i.reg_addr);
+    p = put_field(p, i.reg_data);
+    p = put_field(p, i.mem_addr);
+    p = put_field(p, i.mem_data);
+    *p++ = '"';
+    p = put_mnemonic(p, i.mnemonic);
+    *p++ = '"';
+    *p++ = '\n';
+    out.used = p - out.data.data();
+}
+
+void output_writer(csv_output *out) {
+    string block;
+    while (out->blocks.pop(block)) out->file.write(block.data(), block.size());
+}
+
+unique_ptr<csv_output> open_output(const string &path) {
+    auto out = make_unique<csv_output>();
+    out->file.open(path, ios::binary);
+    if (out->file.is_open()) out->writer = thread(output_writer, out.get());
+    return out;
+}
+
+// Hands the buffer to the writer; queue slots swap their strings, so the buffers are reused
+void flush_output(csv_output *out, bool final) {
+    if (!final && out->buf.used < (1 << 20) - 256) return;
+    if (out->buf.used > 0 && out->writer.joinable()) {
+        out->buf.data.resize(out->buf.used);
+        out->blocks.push(out->buf.data, cancel_writers);
+    }
+    out->buf.used = 0;
+}
+
+void close_output(csv_output *out) {
+    flush_output(out, true);
+    if (!out->writer.joinable()) return;
+    out->blocks.close();
+    out->writer.join();
+}
+
+csv_output *open_hart(int core) {
+    if (core < 0) core = 0;
+    if ((size_t)core >= hart_outputs.size()) hart_outputs.resize(core + 1);
+    if (!hart_outputs[core]) {
+        string path = output_filepath + "spike_outv2_hart" + to_string(core) + ".csv";
+        hart_outputs[core] = open_output(path);
+        if (!hart_outputs[core]->file.is_open()) cerr << "Error opening " << path << "\n";
+    }
+    return hart_outputs[core].get();
+}
+
+void write_row(const instruction_trace &i) {
+    rows_written++;
+    csv_output *out = per_hart_output ? open_hart(i.core) : merged_output.get();
+    append_row(out->buf, i);
+    flush_output(out, false);
+}
+
+// Reports a record that got no line from the other log, listing the first max_diagnostics
+void report_unmatched(const instruction_trace &i) {
+    bool from_commit = i.commit_lineno != 0;
+    long &count = from_commit ? unmatched_commits : unmatched_traces;
+    if (++count + (from_commit ? unmatched_traces : unmatched_commits) > max_diagnostics) return;
+    cerr << "Unmatched " << (from_commit ? "commit_trace.log:" : "instruction_trace.log:")
+         << (from_commit ? i.commit_lineno : i.trace_lineno) << " core " << i.core << " pc 0x" << hex << i.proramming_cnt
+         << " insn 0x" << i.instruction_hex << dec << "\n";
+}
+
+// Writes the finished rows at the front of the window, and the oldest rows beyond its size
+void flush_window(size_t keep) {
+    while (!instr_window.empty()) {
+        const instruction_trace &front = instr_window.front();
+        bool matched = front.commit_lineno != 0 && front.trace_lineno != 0;
+        if (!matched && !front.closed && instr_window.size() <= keep) break;
+        if (!matched) report_unmatched(front);
+        if (front.commit_lineno != 0) write_row(front);
+        instr_window.pop_front();
+    }
+}
+
+// Adds a record from one log to the window, merging it with its waiting counterpart from the other
+void join(const instruction_trace &instr, bool from_commit) {
+    auto it = instr_window.begin();
+    for (; it != instr_window.end(); ++it) {
+        bool waiting = from_commit ? it->commit_lineno == 0 : it->trace_lineno == 0;
+        if (waiting && !it->closed && it->core == instr.core && it->proramming_cnt == instr.proramming_cnt &&
+            it->instruction_hex == instr.instruction_hex) break;
+    }
+    if (it == instr_window.end()) {
+        instr_window.push_back(instr);
+        return;
+    }
+
+    // Records older than either side of the match are skipped lines
+    for (auto old = instr_window.begin(); old != instr_window.end(); ++old) {
+        bool same_log = from_commit ? old->commit_lineno != 0 : old->trace_lineno != 0;
+        bool incomplete = old->commit_lineno == 0 || old->trace_lineno == 0;
+        if (old != it && incomplete && (old < it || same_log)) old->closed = true;
+    }
+    if (from_commit) {
+        instruction_trace merged = instr;
+        merged.mnemonic = it->mnemonic;
+        merged.trace_lineno = it->trace_lineno;
+        *it = merged;
+    } else {
+        it->mnemonic = instr.mnemonic;
+        it->trace_lineno = instr.trace_lineno;
+    }
+}
+
+// Next instruction record of commit_trace.log. Lines that are not records (warnings, trap messages
+// and their continuation lines) are skipped.
+bool read_commit(string_view &text, instruction_trace &instr) {
+    while (next_line(text, commit_line)) {
+        commit_lineno++;
+        field_reader fields(commit_line);
+        uint32_t pc_value;
+        string_view tag = fields.next(), core = fields.next(), thread_field = fields.next();
+        string_view pc = fields.next(pc_value), insn = remove_paren(fields.next());
+        if (insn.empty() || tag != "core" || core.back() != ':' || !is_hex(pc) || !is_hex(insn)) {
+            if (!commit_line.empty()) ignored_lines++;
+            continue;
+        }
+        int core_id = str_to_int(core.substr(0, core.size() - 1));
+        if (in_boot(commit_records, core_id)) continue;
+
+        instr = instruction_trace();
+        instr.commit_lineno = commit_lineno;
+        instr.core = core_id;
+        instr.thread = str_to_int(thread_field);
+        instr.proramming_cnt = pc_value;
+        instr.instruction_hex = hex_to_int(insn);
+
+        // The register write and memory access fields, each with the two fields after it
+        uint32_t hex1, hex2;
+        string_view field = fields.next(), next1 = fields.next(hex1), next2 = fields.next(hex2);
+        for (; !field.empty(); field = next1, next1 = next2, hex1 = hex2, next2 = fields.next(hex2)) {
+            if (field[0] == 'x') {
+                instr.reg_addr = xreg_to_int(field);
+                if (!next1.empty()) instr.reg_data = hex1;
+            }
+            if (field == "mem") {
+                if (!next1.empty()) instr.mem_addr = hex1;
+                if (!next2.empty()) instr.mem_data = hex2;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// The commit log is read on its own thread and handed to the merge loop in batches of records, so on a
+// multi-core machine it is parsed while the main thread reads the trace log, joins and writes. Commit
+// records do not point into the log, so the reader discards the lines it has read itself.
+spsc_queue<vector<instruction_trace>> commit_batches{8};
+vector<instruction_trace> commit_batch; // being joined, from commit_next on
+size_t commit_next = 0;
+atomic<long> commit_lines_read{0};
+atomic<size_t> commit_bytes_read{0};
+
+void commit_reader(mapped_file *file) {
+    string_view text = file->view();
+    vector<instruction_trace> batch;
+    instruction_trace instr;
+    long batches = 0;
+    for (bool more = true; more;) {
+        if ((more = read_commit(text, instr))) batch.push_back(instr);
+        if (more && batch.size() < 4096) continue;
+        commit_lines_read.store(commit_lineno, memory_order_relaxed);
+        commit_bytes_read.store(file->size() - text.size(), memory_order_relaxed);
+        if (++batches % 16 == 0) file->discard(text.data());
+        if (!batch.empty()) commit_batches.push(batch, cancel_writers);
+        batch.clear();
+    }
+    commit_batches.close();
+}
+
+// Next record of the commit log from the reader thread
+bool next_commit(instruction_trace &instr) {
+    if (commit_next == commit_batch.size()) {
+        commit_batch.clear();
+        if (!commit_batches.pop(commit_batch)) return false;
+        commit_next = 0;
+    }
+    instr = commit_batch[commit_next++];
+    return true;
+}
+
+// Next instruction record of instruction_trace.log, skipping lines the same way as read_commit()
+bool read_trace(string_view &text, instruction_trace &instr) {
+    while (next_line(text, trace_line)) {
+        trace_lineno++;
+        field_reader fields(trace_line);
+        uint32_t pc_value;
+        string_view tag = fields.next(), core = fields.next(), pc = fields.next(pc_value);
+        string_view insn = remove_paren(fields.next());
+        if (insn.empty() || tag != "core" || core.back() != ':' || !is_hex(pc) || !is_hex(insn)) {
+            if (!trace_line.empty()) ignored_lines++;
+            continue;
+        }
+        int core_id = str_to_int(core.substr(0, core.size() - 1));
+        if (in_boot(trace_records, core_id)) continue;
+
+        instr = instruction_trace();
+        instr.trace_lineno = trace_lineno;
+        instr.core = core_id;
+        instr.proramming_cnt = pc_value;
+        instr.instruction_hex = hex_to_int(insn);
+        // The mnemonic keeps its original spacing here; it is rejoined with single spaces on output
+        instr.mnemonic = string_view(fields.p, fields.end - fields.p);
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
     auto start = high_resolution_clock::now();
 
+    if (argc > 1) file_path = argv[1];
+    if (argc > 2) output_filepath = argv[2];
     string commit_path = file_path + "commit_trace.log";
     string trace_path = file_path + "instruction_trace.log";
     string output_path = output_filepath + "spike_outv2.csv";
-    
-    ifstream commit_file(commit_path);
-    ifstream trace_file(trace_path);
-    ofstream outfile(output_path);
-    if (!commit_file.is_open() || !trace_file.is_open() || !outfile.is_open()) {
+
+    mapped_file commit_file(commit_path);
+    mapped_file trace_file(trace_path);
+    if (!per_hart_output) merged_output = open_output(output_path);
+    if (!commit_file.is_open() || !trace_file.is_open() || (!per_hart_output && !merged_output->file.is_open())) {
         cerr << "Error opening file!\n";
+        if (merged_output) close_output(merged_output.get());
         return 1;
     }
+    string_view trace_text = trace_file.view();
+    merge_stage.setTotalBytes(commit_file.size() + trace_file.size());
+    auto publish_stats = [&] {
+        merge_stage.set(stage_stats::Bytes, commit_bytes_read + trace_file.size() - trace_text.size());
+        merge_stage.set(stage_stats::Lines, commit_lines_read + trace_lineno);
+        merge_stage.set(stage_stats::Rows, rows_written);
+    };
+    merge_stats.startProgress(progress_seconds);
+    stage_stats::mark merge_start = stage_stats::mark::now(true);
+    thread reader(commit_reader, &commit_file);
 
     //outfile << "core,thread,PC,instruction_hex,reg,reg_data,mem_addr,mem_data,mnemonic\n";
 
     // --------------------- SINGLE WHILE LOOP ----------------------
-    while (getline(commit_file, commit_line) && getline(trace_file, trace_line)) {
-        
-        if(line_count< 6) {    // skip first 6 lines that caused to bootloader instructions in the spike simulation
-            line_count++;
-            continue; 
-        }
-        if (!commit_line.empty() ) { // skip first line
-            vector<string> commit = split(commit_line);
-            instruction_trace instr;
-            instr.core = str_to_int(commit[1].substr(0, commit[1].size() - 1));
-            instr.thread = str_to_int(commit[2]);
-            instr.proramming_cnt = hex_to_int(commit[3]);
-            instr.instruction_hex = hex_to_int(remove_paren(commit[4]));
-
-            for (size_t i = 5; i < commit.size(); ++i) {
-                if (commit[i][0] == 'x') {
-                    instr.reg_addr = xreg_to_int(commit[i]);
-                    if (i + 1 < commit.size()) instr.reg_data = hex_to_int(commit[i + 1]);
-                }
-                if (commit[i] == "mem") {
-                    if (i + 1 < commit.size()) instr.mem_addr = hex_to_int(commit[i + 1]);
-                    if (i + 2 < commit.size()) instr.mem_data = hex_to_int(commit[i + 2]);
-                }
-            }
-            instr_list.push_back(instr);
-        }
-
-        // --------- process trace line ---------&& line_count >= 6
-        if (!trace_line.empty() ) { // skip first line
-            vector<string> commit = split(trace_line);
-            instruction_trace instr;
-            instr.proramming_cnt = hex_to_int(commit[2]);
-            instr.instruction_hex = hex_to_int(remove_paren(commit[3]));
-            for (size_t i = 4; i < commit.size(); i++) {
-                instr.mnemonic += commit[i];
-                if (i != commit.size() - 1) instr.mnemonic += " ";
-            }
+    // One record from each log per iteration; when one log ends the rest of the other is still joined
+    instruction_trace instr;
+    bool commit_more = true, trace_more = true;
+    long records = 0;
+    while (commit_more || trace_more) {
+        if (commit_more && (commit_more = next_commit(instr))) join(instr, true);
+        if (trace_more && (trace_more = read_trace(trace_text, instr))) join(instr, false);
+        flush_window(merge_window);
 
-            // Merge with commit instr if proramming_cnt matches pt < instr_list.size() && 
-            if (instr_list[pt].proramming_cnt == instr.proramming_cnt) {
-                instr_list[pt].mnemonic = instr.mnemonic;
-            } else {
-                instr_list.push_back(instr);
+        // Written lines are not needed any more; mnemonics of waiting rows still point into the trace log
+        if (++records % (1 << 16) == 0) {
+            publish_stats();
+            const char *oldest = trace_text.data();
+            for (const instruction_trace &i : instr_window) {
+                if (i.mnemonic.data() != nullptr) oldest = min(oldest, i.mnemonic.data());
             }
-            pt++;
+            trace_file.discard(oldest);
         }
-        
     }
 
     // --------------------- WRITE CSV ----------------------
-    // if (instr_list.size() > 5) // remove first 5 instructions which cause for the cpu bootloader 
-    //     instr_list.erase(instr_list.begin(), instr_list.begin() + 5);
-
-    for (const instruction_trace &i : instr_list) {
-        outfile << i.core << ","
-                << i.thread << ","
-                << i.proramming_cnt << ","
-                << i.instruction_hex << ","
-                << i.reg_addr << ","
-                << i.reg_data << ","
-                << i.mem_addr << ","
-                << i.mem_data << ","
-                << "\"" << i.mnemonic << "\"" << "\n";
+    reader.join();
+    merge_stage.addPhase("merge", merge_start, true);
+    stage_stats::mark write_start = stage_stats::mark::now(true);
+    flush_window(0);
+    if (merged_output) close_output(merged_output.get());
+    for (auto &h : hart_outputs) {
+        if (h) close_output(h.get());
     }
+    merge_stage.addPhase("write", write_start, true);
+    publish_stats();
+    merge_stage.finish();
+    merge_stats.stopProgress();
 
-    cout << "Merged CSV created: spike_outv2.csv\n";
+    if (per_hart_output) {
+        for (size_t core = 0; core < hart_outputs.size(); ++core) {
+            if (hart_outputs[core]) cout << "Merged CSV created: spike_outv2_hart" << core << ".csv\n";
+        }
+    } else {
+        cout << "Merged CSV created: spike_outv2.csv\n";
+    }
+    if (unmatched_commits + unmatched_traces > 0) {
+        cout << "Unmatched records: " << unmatched_commits << " commit, " << unmatched_traces << " trace";
+        if (unmatched_commits + unmatched_traces > max_diagnostics) cout << " (first " << max_diagnostics << " listed)";
+        cout << "\n";
+    }
+    if (ignored_lines > 0) cout << "Ignored non-instruction lines: " << ignored_lines << "\n";
 
     auto end = high_resolution_clock::now();
     auto duration = duration_cast<microseconds>(end - start);
     cout << "Time taken: " << duration.count() << " us" << endl;
+    if (!stats_file.empty()) merge_stats.writeJson(output_filepath + stats_file);
 
     return 0;
 }